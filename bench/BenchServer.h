@@ -0,0 +1,148 @@
+// File:     bench/BenchServer.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_BENCH_BENCHSERVER_H
+#define WEBSTABLE_BENCH_BENCHSERVER_H
+
+// helpers shared by the bench programs that run the server binary over
+// loopback
+
+// C
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Linux
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace webstab {
+
+namespace bench {
+
+[[noreturn]] inline void die(const char* what) {
+    std::fprintf(stderr, "%s: %s: %s\n", program_invocation_short_name,
+        what, std::strerror(errno));
+    std::exit(1);
+}
+
+inline bool write_file(const std::string& path, const std::string& content) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+    bool ok = std::fwrite(content.data(), 1, content.size(), file)
+        == content.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+// a free port on loopback, chosen by the kernel
+inline int free_port() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (fd == -1 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr),
+            sizeof(addr)) == -1
+            || ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr),
+                &length) == -1)
+        die("free port");
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// a blocking connect to 127.0.0.1, -1 when it failed
+inline int connect_loopback(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+            sizeof(addr)) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// runs 'server -c conf' with its output discarded, returns once it
+// accepts on 'port'
+inline pid_t start_server(const std::string& server, const std::string& conf,
+        int port) {
+    pid_t pid = ::fork();
+    if (pid == -1) die("fork");
+    if (pid == 0) {
+        int null = ::open("/dev/null", O_WRONLY);
+        ::dup2(null, STDOUT_FILENO);
+        ::execl(server.c_str(), server.c_str(), "-c", conf.c_str(),
+            static_cast<char*>(nullptr));
+        std::_Exit(127);
+    }
+    for (int i = 0; i < 250; ++i) {
+        int fd = connect_loopback(port);
+        if (fd != -1) {
+            ::close(fd);
+            return pid;
+        }
+        int status;
+        if (::waitpid(pid, &status, WNOHANG) == pid) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    std::fprintf(stderr, "%s: %s did not start\n",
+        program_invocation_short_name, server.c_str());
+    std::exit(1);
+}
+
+// false when the server is gone, after a crash
+inline bool server_alive(pid_t pid) {
+    int status;
+    return ::waitpid(pid, &status, WNOHANG) == 0;
+}
+
+inline void stop_server(pid_t pid) {
+    ::kill(pid, SIGKILL);
+    int status;
+    ::waitpid(pid, &status, 0);
+}
+
+} // namespace bench
+
+} // namespace webstab
+
+#endif // WEBSTABLE_BENCH_BENCHSERVER_H
@@ -0,0 +1,487 @@
+// File:     bench/LoadBench.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// webstable_bench: starts the server on loopback under each poller and
+// drives it with an epoll load generator, one scenario after another.
+// the files, the request mix and the order of the runs are fixed, so two
+// runs on the same machine are comparable
+//
+//   webstable_bench [--server PATH] [--poller NAME]... [--duration S]
+//                   [--warmup S] [--threads N] [--server-threads N]
+//                   [--seed N]
+
+// C
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Linux
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// WebStable
+#include "core/Metrics.h"
+
+// bench
+#include "BenchServer.h"
+
+#ifndef WEBSTABLE_BINARY
+#define WEBSTABLE_BINARY "webstable"
+#endif
+
+namespace webstab {
+
+namespace {
+
+// the files served, their bytes follow a fixed pattern
+struct BenchFile {
+    const char* name;
+    size_t size;
+};
+
+constexpr BenchFile Files[] = {
+    { "1k.html", 1024 },
+    { "16k.html", 16 * 1024 },
+    { "256k.bin", 256 * 1024 },
+    { "2m.bin", 2 * 1024 * 1024 },
+};
+constexpr size_t FileCount = sizeof(Files) / sizeof(Files[0]);
+
+// how often each of Files is requested
+struct FileMix {
+    const char* name;
+    double weights[FileCount];
+};
+
+constexpr FileMix SmallMix { "small", { 70, 30, 0, 0 } };
+constexpr FileMix MixedMix { "mixed", { 50, 30, 15, 5 } };
+
+struct Scenario {
+    const char* name;
+    const FileMix* mix;
+    bool keep_alive;
+    size_t depth;
+    size_t connections;
+};
+
+const Scenario Scenarios[] = {
+    { "keepalive", &SmallMix, true, 1, 64 },
+    { "keepalive", &MixedMix, true, 1, 64 },
+    { "pipeline", &SmallMix, true, 8, 64 },
+    { "close", &SmallMix, false, 1, 64 },
+    { "keepalive", &SmallMix, true, 1, 512 },
+};
+
+struct Options {
+    std::string server = WEBSTABLE_BINARY;
+    std::vector<std::string> pollers;
+    double duration = 3.0;
+    double warmup = 0.5;
+    size_t threads = 2;
+    size_t server_threads = 4;
+    unsigned seed = 1;
+};
+
+// a run goes through these phases, responses are counted in Measure only
+enum Phase : int { Warmup, Measure, Stop };
+
+struct Result {
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyBuckets);
+    uint64_t responses = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+};
+
+// a client connection and the requests it has in flight
+struct Connection {
+    int fd = -1;
+    std::string out;
+    size_t out_offset = 0;
+    std::deque<uint64_t> sent;
+
+    // the response being received
+    std::string head;
+    bool in_body = false;
+    size_t body_left = 0;
+    int status = 0;
+};
+
+// a blocking connect, then non-blocking. -1 when it failed
+int connect_(int port, bool keep_alive) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return -1;
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (!keep_alive) {
+        // reset on close, so that closed connections do not take every
+        // local port in TIME_WAIT
+        linger reset { 1, 0 };
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    }
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+            sizeof(addr)) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+class Client {
+    const Scenario& scenario_;
+    int port_;
+    const std::atomic<int>& phase_;
+    std::atomic<size_t>& ready_;
+    std::mt19937 random_;
+    std::discrete_distribution<size_t> pick_;
+    std::vector<Connection> connections_;
+    int epoll_ = -1;
+    Result result_;
+
+private:
+    void open_(Connection& c) {
+        c = Connection();
+        c.fd = connect_(port_, scenario_.keep_alive);
+        if (c.fd == -1) {
+            ++result_.errors;
+            return;
+        }
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.ptr = &c;
+        ::epoll_ctl(epoll_, EPOLL_CTL_ADD, c.fd, &event);
+    }
+
+    void close_(Connection& c) {
+        if (c.fd != -1) ::close(c.fd);
+        c.fd = -1;
+    }
+
+    void flush_(Connection& c) {
+        while (c.out_offset < c.out.size()) {
+            ssize_t ret = ::send(c.fd, c.out.data() + c.out_offset,
+                c.out.size() - c.out_offset, MSG_NOSIGNAL);
+            if (ret == -1) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN) return;
+                // the rest leaves when the socket is writable
+                epoll_event event {};
+                event.events = EPOLLIN | EPOLLOUT;
+                event.data.ptr = &c;
+                ::epoll_ctl(epoll_, EPOLL_CTL_MOD, c.fd, &event);
+                return;
+            }
+            c.out_offset += static_cast<size_t>(ret);
+        }
+        c.out.clear();
+        c.out_offset = 0;
+    }
+
+    // keeps 'depth' requests in flight
+    void fill_(Connection& c) {
+        if (c.fd == -1) open_(c);
+        if (c.fd == -1) return;
+        while (c.sent.size() < scenario_.depth) {
+            c.out += "GET /";
+            c.out += Files[pick_(random_)].name;
+            c.out += " HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+            if (!scenario_.keep_alive) c.out += "Connection: close\r\n";
+            c.out += "\r\n";
+            c.sent.push_back(Metrics::now());
+        }
+        flush_(c);
+    }
+
+    void complete_(Connection& c) {
+        uint64_t now = Metrics::now();
+        if (phase_.load(std::memory_order_relaxed) == Measure) {
+            ++result_.buckets[Metrics::bucket(now - c.sent.front())];
+            ++result_.responses;
+            if (c.status != 200) ++result_.errors;
+        }
+        c.sent.pop_front();
+        c.head.clear();
+        c.in_body = false;
+    }
+
+    // parses what arrived, false when the connection must be reopened
+    bool receive_(Connection& c, const char* data, size_t length) {
+        while (length) {
+            if (!c.in_body) {
+                // the head is kept until its blank line arrives
+                size_t old = c.head.size();
+                c.head.append(data, length);
+                size_t end = c.head.find("\r\n\r\n",
+                    old >= 3 ? old - 3 : 0);
+                if (end == std::string::npos) return true;
+                size_t used = end + 4 - old;
+                data += used;
+                length -= used;
+                c.head.resize(end + 4);
+                c.status = c.head.compare(0, 9, "HTTP/1.1 ") == 0
+                    ? std::atoi(c.head.c_str() + 9) : 0;
+                const char* field = ::strcasestr(c.head.c_str(),
+                    "\r\nContent-Length:");
+                if (field == nullptr) return false;
+                c.body_left = std::strtoul(field + 17, nullptr, 10);
+                c.in_body = true;
+            }
+            size_t take = std::min(length, c.body_left);
+            c.body_left -= take;
+            data += take;
+            length -= take;
+            if (c.body_left == 0) {
+                complete_(c);
+                if (!scenario_.keep_alive) return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    Client(const Scenario& scenario, int port, size_t connections,
+            unsigned seed, const std::atomic<int>& phase,
+            std::atomic<size_t>& ready)
+            : scenario_(scenario), port_(port), phase_(phase),
+            ready_(ready), random_(seed),
+            pick_(std::begin(scenario.mix->weights),
+                std::end(scenario.mix->weights)),
+            connections_(connections) {}
+
+    ~Client() {
+        for (Connection& c : connections_) close_(c);
+        if (epoll_ != -1) ::close(epoll_);
+    }
+
+    void run() {
+        epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_ == -1) bench::die("epoll_create1");
+        for (Connection& c : connections_) fill_(c);
+        ready_.fetch_add(1);
+
+        std::vector<epoll_event> events(256);
+        std::vector<char> buf(256 * 1024);
+        while (phase_.load(std::memory_order_relaxed) != Stop) {
+            int n = ::epoll_wait(epoll_, events.data(),
+                static_cast<int>(events.size()), 10);
+            for (int i = 0; i < n; ++i) {
+                Connection& c = *static_cast<Connection*>(events[i].data.ptr);
+                if (events[i].events & EPOLLOUT) {
+                    flush_(c);
+                    if (c.out.empty()) {
+                        epoll_event event {};
+                        event.events = EPOLLIN;
+                        event.data.ptr = &c;
+                        ::epoll_ctl(epoll_, EPOLL_CTL_MOD, c.fd, &event);
+                    }
+                }
+                if (!(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+                    continue;
+                ssize_t ret = ::recv(c.fd, buf.data(), buf.size(), 0);
+                if (ret == -1 && (errno == EAGAIN || errno == EINTR))
+                    continue;
+                if (ret > 0 && phase_.load(std::memory_order_relaxed)
+                        == Measure)
+                    result_.bytes += static_cast<uint64_t>(ret);
+                bool keep = ret > 0
+                    && receive_(c, buf.data(), static_cast<size_t>(ret));
+                if (!keep) {
+                    // closed after a full response, or failed
+                    if (!c.sent.empty()
+                            && phase_.load(std::memory_order_relaxed)
+                                == Measure)
+                        ++result_.errors;
+                    close_(c);
+                }
+                fill_(c);
+            }
+        }
+    }
+
+    inline const Result& result() const { return result_; }
+};
+
+void run_scenario_(const Options& options, const char* poller,
+        const Scenario& scenario, int port) {
+    std::atomic<int> phase { Warmup };
+    std::atomic<size_t> ready { 0 };
+    std::vector<std::unique_ptr<Client>> clients;
+    std::vector<std::thread> threads;
+    size_t threads_num = std::min(options.threads, scenario.connections);
+    for (size_t i = 0; i < threads_num; ++i) {
+        size_t connections = scenario.connections / threads_num
+            + (i < scenario.connections % threads_num ? 1 : 0);
+        clients.emplace_back(new Client(scenario, port, connections,
+            options.seed + static_cast<unsigned>(i), phase, ready));
+    }
+    for (auto& client : clients)
+        threads.emplace_back([&client]() { client->run(); });
+
+    // the warmup starts once every connection is open, connecting may
+    // take a while when the listen backlog overflows
+    while (ready.load() < clients.size())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    using seconds = std::chrono::duration<double>;
+    std::this_thread::sleep_for(seconds(options.warmup));
+    phase.store(Measure);
+    uint64_t start = Metrics::now();
+    std::this_thread::sleep_for(seconds(options.duration));
+    phase.store(Stop);
+    double elapsed = static_cast<double>(Metrics::now() - start) / 1e9;
+    for (std::thread& thread : threads) thread.join();
+
+    Result total;
+    for (const auto& client : clients) {
+        const Result& result = client->result();
+        for (size_t i = 0; i < LatencyBuckets; ++i)
+            total.buckets[i] += result.buckets[i];
+        total.responses += result.responses;
+        total.bytes += result.bytes;
+        total.errors += result.errors;
+    }
+    auto micros = [&total](double q) {
+        return total.responses == 0 ? 0.0 : static_cast<double>(
+            Metrics::quantile(total.buckets.data(), total.responses, q))
+            / 1e3;
+    };
+    std::printf("%-7s %-10s %-6s %6zu %6zu %12.1f %9.1f %9.1f %9.1f %9.1f"
+        " %8llu\n", poller, scenario.name, scenario.mix->name,
+        scenario.connections, scenario.depth,
+        static_cast<double>(total.responses) / elapsed,
+        static_cast<double>(total.bytes) / elapsed / (1024.0 * 1024.0),
+        micros(0.5), micros(0.99), micros(0.999),
+        static_cast<unsigned long long>(total.errors));
+    std::fflush(stdout);
+}
+
+Options parse_options_(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "webstable_bench: %s needs a value\n",
+                arg.c_str());
+            std::exit(2);
+        }
+        const char* value = argv[++i];
+        if (arg == "--server") options.server = value;
+        else if (arg == "--poller") options.pollers.push_back(value);
+        else if (arg == "--duration") options.duration = std::atof(value);
+        else if (arg == "--warmup") options.warmup = std::atof(value);
+        else if (arg == "--threads")
+            options.threads = std::strtoul(value, nullptr, 10);
+        else if (arg == "--server-threads")
+            options.server_threads = std::strtoul(value, nullptr, 10);
+        else if (arg == "--seed")
+            options.seed = static_cast<unsigned>(
+                std::strtoul(value, nullptr, 10));
+        else {
+            std::fprintf(stderr, "webstable_bench: unknown option %s\n",
+                arg.c_str());
+            std::exit(2);
+        }
+    }
+    if (options.pollers.empty())
+        options.pollers = { "select", "poll", "epoll" };
+    if (options.threads == 0) options.threads = 1;
+    return options;
+}
+
+} // anonymous namespace
+
+} // namespace webstab
+
+int main(int argc, char* argv[]) {
+    using namespace webstab;
+    Options options = parse_options_(argc, argv);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    // the document root, removed at the end
+    char dir_template[] = "/tmp/webstable-bench-XXXXXX";
+    if (::mkdtemp(dir_template) == nullptr) bench::die("mkdtemp");
+    std::string dir = dir_template;
+    for (const BenchFile& file : Files) {
+        std::string content(file.size, '\0');
+        for (size_t i = 0; i < file.size; ++i)
+            content[i] = static_cast<char>('a' + i % 26);
+        if (!bench::write_file(dir + '/' + file.name, content))
+            bench::die(file.name);
+    }
+
+    std::printf("%-7s %-10s %-6s %6s %6s %12s %9s %9s %9s %9s %8s\n",
+        "poller", "scenario", "files", "conns", "depth", "req/s", "MiB/s",
+        "p50(us)", "p99(us)", "p999(us)", "errors");
+    for (const std::string& poller : options.pollers) {
+        int port = bench::free_port();
+        std::string conf = dir + "/bench.conf";
+        std::string text = "[server]\nlisten = 127.0.0.1:"
+            + std::to_string(port)
+            + "\nthreads_num = " + std::to_string(options.server_threads)
+            + "\npoller = " + poller
+            + "\nkeepalive = 60\ncache_size = 64m\ncache_max_file_size = 4m"
+            + "\n[static]\nroot = " + dir + '\n';
+        if (!bench::write_file(conf, text)) bench::die("bench.conf");
+        pid_t pid = bench::start_server(options.server, conf, port);
+        for (const Scenario& scenario : Scenarios) {
+            run_scenario_(options, poller.c_str(), scenario, port);
+            if (!bench::server_alive(pid)) {
+                // reported and restarted, the next scenarios still run
+                std::printf("%-7s server exited\n", poller.c_str());
+                pid = bench::start_server(options.server, conf, port);
+            }
+        }
+        bench::stop_server(pid);
+        ::unlink(conf.c_str());
+    }
+
+    for (const BenchFile& file : Files)
+        ::unlink((dir + '/' + file.name).c_str());
+    ::rmdir(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,262 @@
+// File:     bench/MicroBench.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// webstable_microbench: Google Benchmark cases for the classes on the
+// request path. compare runs with
+//
+//   webstable_microbench --benchmark_out=new.json --benchmark_out_format=json
+//   compare.py benchmarks base.json new.json
+
+// C
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++
+#include <memory>
+#include <string>
+#include <vector>
+
+// Linux
+#include <unistd.h>
+
+// benchmark
+#include <benchmark/benchmark.h>
+
+// WebStable
+#include "app/Config.h"
+#include "app/MimeTable.h"
+#include "file/FileCache.h"
+#include "http/HttpRequest.h"
+#include "http/RequestReceiver.h"
+#include "http/ResponseWriter.h"
+#include "thread/ThreadPool.h"
+#include "thread/TimerWheel.h"
+
+namespace webstab {
+
+namespace {
+
+// files and a configuration in a temporary directory, removed at exit
+class Fixture {
+    std::string dir_;
+    std::vector<std::string> files_;
+
+public:
+    Fixture() {
+        char dir[] = "/tmp/webstable-microbench-XXXXXX";
+        if (::mkdtemp(dir) == nullptr) std::abort();
+        dir_ = dir;
+        write("1k.html", std::string(1024, 'a'));
+        write("64k.html", std::string(64 * 1024, 'b'));
+        write("bench.conf", "[server]\n"
+            "[static]\n"
+            "root = " + dir_ + "\n"
+            "[types]\n"
+            "html htm = text/html\n"
+            "css = text/css\n"
+            "js mjs = application/javascript\n"
+            "json = application/json\n"
+            "xml = application/xml\n"
+            "txt = text/plain\n"
+            "svg = image/svg+xml\n"
+            "png = image/png\n"
+            "jpg jpeg = image/jpeg\n"
+            "gif = image/gif\n"
+            "webp = image/webp\n"
+            "ico = image/x-icon\n"
+            "woff = font/woff\n"
+            "woff2 = font/woff2\n"
+            "mp4 = video/mp4\n"
+            "pdf = application/pdf\n"
+            "zip = application/zip\n"
+            "wasm = application/wasm\n");
+    }
+
+    ~Fixture() {
+        for (const std::string& file : files_) ::unlink(file.c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    void write(const std::string& name, const std::string& content) {
+        std::string path = dir_ + '/' + name;
+        FILE* file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) std::abort();
+        std::fwrite(content.data(), 1, content.size(), file);
+        std::fclose(file);
+        files_.push_back(path);
+    }
+
+    inline std::string path(const std::string& name) const {
+        return dir_ + '/' + name;
+    }
+};
+
+Fixture& fixture_() {
+    static Fixture fixture;
+    return fixture;
+}
+
+std::string request_with_headers_(size_t headers) {
+    std::string request = "GET /index.html?v=1 HTTP/1.1\r\n"
+        "Host: bench.example\r\n";
+    for (size_t i = 1; i < headers; ++i)
+        request += "X-Header-" + std::to_string(i)
+            + ": some value of the header " + std::to_string(i) + "\r\n";
+    return request + "\r\n";
+}
+
+std::string chunked_request_(size_t chunks) {
+    std::string request = "POST /upload HTTP/1.1\r\nHost: bench.example\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n";
+    for (size_t i = 0; i < chunks; ++i)
+        request += "100\r\n" + std::string(256, 'x') + "\r\n";
+    return request + "0\r\n\r\n";
+}
+
+void receive_(benchmark::State& state, const std::string& input) {
+    BodyPolicy policy;
+    policy.buffer_size = 1024 * 1024;
+    for (auto _ : state) {
+        HttpRequest request;
+        RequestReceiver receiver(request, policy);
+        std::memcpy(receiver.prepare(input.size()), input.data(),
+            input.size());
+        receiver.commit(input.size());
+        if (!receiver.done()) state.SkipWithError("request not complete");
+        benchmark::DoNotOptimize(request.path.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations())
+        * static_cast<int64_t>(input.size()));
+}
+
+} // anonymous namespace
+
+void BM_RequestReceiver_Headers(benchmark::State& state) {
+    receive_(state, request_with_headers_(
+        static_cast<size_t>(state.range(0))));
+}
+BENCHMARK(BM_RequestReceiver_Headers)->Arg(1)->Arg(8)->Arg(16)->Arg(31);
+
+void BM_RequestReceiver_Chunked(benchmark::State& state) {
+    receive_(state, chunked_request_(static_cast<size_t>(state.range(0))));
+}
+BENCHMARK(BM_RequestReceiver_Chunked)->Arg(1)->Arg(16)->Arg(64);
+
+// the head of a cached file as Responser writes it, 200 for the whole
+// file or 206 for a range of it. the Date line is formatted once per
+// second and otherwise copied
+void BM_ResponseWriter_Head(benchmark::State& state) {
+    const bool partial = state.range(0) != 0;
+    char head[1024];
+    for (auto _ : state) {
+        ResponseWriter writer(head, sizeof(head));
+        writer.status(partial ? 206 : 200);
+        writer.date();
+        writer.header("Server", "WebStable");
+        writer.header("Content-Type", "text/html");
+        writer.header("Content-Length", size_t(partial ? 1024 : 65536));
+        if (partial)
+            writer.header("Content-Range", "bytes 1024-2047/65536");
+        writer.header("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+        writer.header("ETag", "\"6553a1c0-10000\"");
+        writer.header("Accept-Ranges", "bytes");
+        benchmark::DoNotOptimize(writer.finish());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ResponseWriter_Head)->Arg(0)->Arg(1);
+
+// every thread reads the same cached file
+void BM_FileCache_Hit(benchmark::State& state) {
+    static FileCache cache;
+    static const std::string path = fixture_().path("1k.html");
+    CachePolicy policy;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get_file(path, policy, true));
+}
+BENCHMARK(BM_FileCache_Hit)->ThreadRange(1, 8)->UseRealTime();
+
+// a cache without room, every call loads the file again
+void BM_FileCache_Miss(benchmark::State& state) {
+    static FileCache cache(0);
+    static const std::string path = fixture_().path("64k.html");
+    CachePolicy policy;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get_file(path, policy, false));
+}
+BENCHMARK(BM_FileCache_Miss)->ThreadRange(1, 8)->UseRealTime();
+
+// sockets timed and cancelled again, the wheel is never started so that
+// nothing is closed
+void BM_TimerWheel_TimingCancel(benchmark::State& state) {
+    static TimerWheel timer(30);
+    nano::sock_t base = static_cast<nano::sock_t>(state.thread_index())
+        << 20;
+    nano::sock_t sock = 0;
+    for (auto _ : state) {
+        timer.timing(base + sock);
+        timer.cancel(base + sock);
+        sock = (sock + 1) & 1023;
+    }
+}
+BENCHMARK(BM_TimerWheel_TimingCancel)->ThreadRange(1, 8)->UseRealTime();
+
+// pushes of sockets that the workers drop. the pool is left running
+// until the process exits
+void BM_ThreadPool_Push(benchmark::State& state) {
+    static ThreadPool* pool = [] {
+        ThreadPool* pool = new ThreadPool(4);
+        pool->set_task([](nano::sock_t) {});
+        return pool;
+    }();
+    nano::sock_t sock = 0;
+    for (auto _ : state)
+        pool->push(sock++);
+}
+BENCHMARK(BM_ThreadPool_Push)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_Config_Type(benchmark::State& state) {
+    static const Config config = Config::load(fixture_().path("bench.conf"));
+    const std::string extension = state.range(0) ? "woff2" : "unknown";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(config.type(extension));
+}
+BENCHMARK(BM_Config_Type)->Arg(1)->Arg(0);
+
+// the table that replaced Config::type() on the request path
+void BM_MimeTable_Lookup(benchmark::State& state) {
+    static const MimeTable types(
+        Config::load(fixture_().path("bench.conf")));
+    const std::string extension = state.range(0) ? "woff2" : "unknown";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(&types.lookup(extension));
+}
+BENCHMARK(BM_MimeTable_Lookup)->Arg(1)->Arg(0);
+
+} // namespace webstab
+
+BENCHMARK_MAIN();
@@ -0,0 +1,518 @@
+// File:     bench/SoakBench.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// webstable_soak: starts the server on loopback and holds N idle
+// connections against it, first only accepted and then again after one
+// keep-alive request on each. after every phase it samples the server's
+// RSS, its /status gauges and the kernel slabs of sockets and epoll, and
+// reports what a connection costs and how long the server took to accept
+// the whole set. with --max-bytes it fails when an idle connection costs
+// more server RSS than that, so it can gate memory regressions
+//
+//   webstable_soak [--server PATH] [--poller NAME] [--connections N]
+//                  [--per-source N] [--server-threads N] [--max-bytes N]
+//
+// the connections come from 127.0.0.1, 127.0.0.2, ... with --per-source
+// of them on each address, so the count is not bound by the ephemeral
+// ports of one source. the server and this program each hold one end of
+// every connection, the file limit must allow that many descriptors
+
+// C
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Linux
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// WebStable
+#include "core/Metrics.h"
+
+// bench
+#include "BenchServer.h"
+
+#ifndef WEBSTABLE_BINARY
+#define WEBSTABLE_BINARY "webstable"
+#endif
+
+namespace webstab {
+
+namespace {
+
+constexpr const char Request[] = "GET /idle.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n\r\n";
+
+// connects in progress at a time, the server's listen backlog is short
+constexpr size_t ConnectWindow = 256;
+
+// a phase that made no progress for this many seconds is reported as
+// incomplete
+constexpr double StallTimeout = 20;
+
+struct Options {
+    std::string server = WEBSTABLE_BINARY;
+    std::string poller = "epoll";
+    size_t connections = 10000;
+    size_t per_source = 20000;
+    size_t server_threads = 4;
+    uint64_t max_bytes = 0;
+};
+
+// one look at the server and the kernel
+struct Sample {
+    uint64_t rss = 0;
+    uint64_t sockets = 0;
+    uint64_t epoll = 0;
+    std::map<std::string, double> status;
+
+    double gauge(const char* name) const {
+        auto it = status.find(name);
+        return it == status.end() ? 0 : it->second;
+    }
+};
+
+// VmRSS of the process, in bytes
+uint64_t rss_(pid_t pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+    return 0;
+}
+
+// bytes in use in the named slab caches, 0 when /proc/slabinfo is not
+// readable
+uint64_t slab_bytes_(std::initializer_list<const char*> names) {
+    std::ifstream file("/proc/slabinfo");
+    std::string line;
+    uint64_t bytes = 0;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        uint64_t active = 0, total = 0, size = 0;
+        if (!(fields >> name >> active >> total >> size)) continue;
+        for (const char* wanted : names)
+            if (name == wanted) bytes += active * size;
+    }
+    return bytes;
+}
+
+// memory of TCP socket buffers, from /proc/net/sockstat
+uint64_t tcp_buffers_() {
+    std::ifstream file("/proc/net/sockstat");
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t at = line.find(" mem ");
+        if (line.compare(0, 4, "TCP:") == 0 && at != std::string::npos)
+            return std::strtoull(line.c_str() + at + 5, nullptr, 10)
+                * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+}
+
+// reads one response from a blocking socket, false on a failure
+bool read_response_(int fd, std::string& response) {
+    response.clear();
+    char buffer[16384];
+    while (true) {
+        size_t end = response.find("\r\n\r\n");
+        if (end != std::string::npos) {
+            size_t at = response.find("Content-Length:");
+            size_t length = at < end
+                ? std::strtoull(response.c_str() + at + 15, nullptr, 10) : 0;
+            if (response.size() >= end + 4 + length) return true;
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        response.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+// the values on the server's /status page, by name and labels
+std::map<std::string, double> status_(int port) {
+    std::map<std::string, double> values;
+    int fd = bench::connect_loopback(port);
+    if (fd == -1) return values;
+    timeval timeout { 5, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    const char request[] = "GET /status HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+        "Connection: close\r\n\r\n";
+    std::string response;
+    if (::send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) != -1
+            && read_response_(fd, response)) {
+        std::istringstream lines(
+            response.substr(response.find("\r\n\r\n") + 4));
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t space = line.rfind(' ');
+            if (line.empty() || line[0] == '#' || space == std::string::npos)
+                continue;
+            values[line.substr(0, space)] = std::strtod(
+                line.c_str() + space + 1, nullptr);
+        }
+    }
+    ::close(fd);
+    return values;
+}
+
+Sample sample_(pid_t pid, int port) {
+    Sample sample;
+    sample.rss = rss_(pid);
+    sample.sockets = tcp_buffers_()
+        + slab_bytes_({ "TCP", "sock_inode_cache", "filp", "dentry" });
+    sample.epoll = slab_bytes_({ "eventpoll_epi", "eventpoll_pwq" });
+    sample.status = status_(port);
+    return sample;
+}
+
+double seconds_since_(uint64_t start) {
+    return static_cast<double>(Metrics::now() - start) / 1e9;
+}
+
+// opens 'count' connections to the server, with at most ConnectWindow
+// connects in flight. the sockets are left in 'fds', non-blocking
+void open_connections_(int port, const Options& options,
+        std::vector<int>& fds) {
+    int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll == -1) bench::die("epoll_create1");
+    size_t started = 0, in_flight = 0, failed = 0;
+    uint64_t progress = Metrics::now();
+    std::vector<epoll_event> events(ConnectWindow);
+    while (fds.size() < options.connections
+            && seconds_since_(progress) < StallTimeout) {
+        while (in_flight < ConnectWindow
+                && started - failed < options.connections) {
+            int fd = ::socket(AF_INET,
+                SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd == -1) bench::die("socket");
+            // the port is chosen at connect, by the whole 4-tuple
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one,
+                sizeof(one));
+            sockaddr_in addr {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK
+                + static_cast<uint32_t>(started / options.per_source));
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&addr),
+                    sizeof(addr)) == -1)
+                bench::die("bind");
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ++started;
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                    sizeof(addr)) == 0) {
+                fds.push_back(fd);
+                continue;
+            } else if (errno != EINPROGRESS) {
+                ::close(fd);
+                ++failed;
+                continue;
+            }
+            epoll_event event {};
+            event.events = EPOLLOUT;
+            event.data.fd = fd;
+            if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) == -1)
+                bench::die("epoll_ctl");
+            ++in_flight;
+        }
+        int n = ::epoll_wait(epoll, events.data(),
+            static_cast<int>(events.size()), 1000);
+        for (int i = 0; i < n; ++i) {
+            progress = Metrics::now();
+            int fd = events[i].data.fd, error = 0;
+            socklen_t length = sizeof(error);
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            ::epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+            --in_flight;
+            if (error == 0) {
+                fds.push_back(fd);
+            } else {
+                // started again, up to the count
+                ::close(fd);
+                ++failed;
+            }
+        }
+    }
+    ::close(epoll);
+    if (failed != 0)
+        std::printf("%zu connects failed and were retried\n", failed);
+}
+
+// waits until the server counts 'count' more connections accepted than
+// in 'base'. each look at /status is one more of them
+bool wait_accepted_(int port, const Sample& base, size_t count) {
+    const char* name = "webstable_connections_accepted_total";
+    double want = base.gauge(name) + static_cast<double>(count), last = 0;
+    uint64_t progress = Metrics::now();
+    for (size_t looks = 1; seconds_since_(progress) < StallTimeout;
+            ++looks) {
+        double accepted = status_(port)[name] - static_cast<double>(looks);
+        if (accepted >= want) return true;
+        if (accepted > last) {
+            last = accepted;
+            progress = Metrics::now();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// sends one keep-alive request on each connection and reads the
+// responses, returns the number answered
+size_t request_all_(const std::vector<int>& fds) {
+    int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll == -1) bench::die("epoll_create1");
+    std::vector<std::string> responses(fds.size());
+    for (size_t i = 0; i < fds.size(); ++i) {
+        if (::send(fds[i], Request, sizeof(Request) - 1, MSG_NOSIGNAL)
+                != static_cast<ssize_t>(sizeof(Request) - 1))
+            continue;
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        if (::epoll_ctl(epoll, EPOLL_CTL_ADD, fds[i], &event) == -1)
+            bench::die("epoll_ctl");
+    }
+    size_t answered = 0;
+    uint64_t progress = Metrics::now();
+    std::vector<epoll_event> events(1024);
+    char buffer[4096];
+    while (answered < fds.size()
+            && seconds_since_(progress) < StallTimeout) {
+        int n = ::epoll_wait(epoll, events.data(),
+            static_cast<int>(events.size()), 1000);
+        for (int i = 0; i < n; ++i) {
+            size_t index = events[i].data.u64;
+            std::string& response = responses[index];
+            ssize_t got = ::recv(fds[index], buffer, sizeof(buffer), 0);
+            if (got > 0) response.append(buffer, static_cast<size_t>(got));
+            size_t end = response.find("\r\n\r\n");
+            size_t at = response.find("Content-Length:");
+            bool done = end != std::string::npos && at < end
+                && response.size() >= end + 4 + std::strtoull(
+                    response.c_str() + at + 15, nullptr, 10);
+            if (done) {
+                ++answered;
+                progress = Metrics::now();
+            }
+            if (done || got <= 0)
+                ::epoll_ctl(epoll, EPOLL_CTL_DEL, fds[index], nullptr);
+        }
+    }
+    ::close(epoll);
+    return answered;
+}
+
+// waits until the server times 'count' keep-alive connections
+void wait_idle_(int port, size_t count) {
+    uint64_t start = Metrics::now();
+    while (seconds_since_(start) < StallTimeout) {
+        std::map<std::string, double> values = status_(port);
+        if (values["webstable_idle_connections"]
+                >= static_cast<double>(count))
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+// connections the server holds, the divisor of the per connection
+// columns. the client may count some that the server never accepted
+double held_(const Sample& sample, const Sample& base) {
+    const char* name = "webstable_connections_open";
+    return std::max(sample.gauge(name) - base.gauge(name), 1.0);
+}
+
+double per_(uint64_t bytes, uint64_t base, double count) {
+    return (static_cast<double>(bytes) - static_cast<double>(base))
+        / count;
+}
+
+void print_(const char* phase, double seconds, const Sample& sample,
+        const Sample& base) {
+    double count = held_(sample, base);
+    std::printf("%-9s %8.2f %10.0f %9.0f %9.0f %9.0f %9.0f %8.0f %8.0f\n",
+        phase, seconds, static_cast<double>(sample.rss) / 1024,
+        per_(sample.rss, base.rss, count),
+        per_(static_cast<uint64_t>(sample.gauge("webstable_timer_bytes")),
+            static_cast<uint64_t>(base.gauge("webstable_timer_bytes")),
+            count),
+        per_(sample.sockets, base.sockets, count),
+        per_(sample.epoll, base.epoll, count),
+        sample.gauge("webstable_connections_open"),
+        sample.gauge("webstable_idle_connections"));
+}
+
+[[noreturn]] void usage_() {
+    std::fprintf(stderr,
+        "usage: webstable_soak [--server PATH] [--poller NAME]\n"
+        "                      [--connections N] [--per-source N]\n"
+        "                      [--server-threads N] [--max-bytes N]\n");
+    std::exit(2);
+}
+
+Options parse_options_(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 == argc) usage_();
+        const char* value = argv[++i];
+        if (arg == "--server") options.server = value;
+        else if (arg == "--poller") options.poller = value;
+        else if (arg == "--connections")
+            options.connections = std::strtoul(value, nullptr, 10);
+        else if (arg == "--per-source")
+            options.per_source = std::strtoul(value, nullptr, 10);
+        else if (arg == "--server-threads")
+            options.server_threads = std::strtoul(value, nullptr, 10);
+        else if (arg == "--max-bytes")
+            options.max_bytes = std::strtoull(value, nullptr, 10);
+        else usage_();
+    }
+    if (options.connections == 0 || options.per_source == 0) usage_();
+    if (options.server_threads == 0) options.server_threads = 1;
+    return options;
+}
+
+} // anonymous namespace
+
+} // namespace webstab
+
+int main(int argc, char* argv[]) {
+    using namespace webstab;
+    Options options = parse_options_(argc, argv);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    // the server inherits the limit raised here
+    rlimit files;
+    ::getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &files);
+    if (files.rlim_cur < options.connections + 64) {
+        std::fprintf(stderr, "webstable_soak: %zu connections need more "
+            "than the file limit of %llu\n", options.connections,
+            static_cast<unsigned long long>(files.rlim_cur));
+        return 1;
+    }
+
+    char dir_template[] = "/tmp/webstable-soak-XXXXXX";
+    if (::mkdtemp(dir_template) == nullptr) bench::die("mkdtemp");
+    std::string dir = dir_template;
+    std::string page = dir + "/idle.html", conf = dir + "/soak.conf";
+    int port = bench::free_port();
+    std::string text = "[server]\nlisten = 127.0.0.1:"
+        + std::to_string(port)
+        + "\nthreads_num = " + std::to_string(options.server_threads)
+        + "\npoller = " + options.poller
+        + "\nkeepalive = 3600\nstatus_path = /status"
+        + "\n[static]\nroot = " + dir + '\n';
+    if (!bench::write_file(page, "idle\n")) bench::die("idle.html");
+    if (!bench::write_file(conf, text)) bench::die("soak.conf");
+    pid_t pid = bench::start_server(options.server, conf, port);
+
+    size_t sources = (options.connections + options.per_source - 1)
+        / options.per_source;
+    std::printf("%s poller, %zu connections from %zu source address%s\n",
+        options.poller.c_str(), options.connections, sources,
+        sources == 1 ? "" : "es");
+    std::printf("bytes per connection, the kernel columns count both ends\n"
+        "\n%-9s %8s %10s %9s %9s %9s %9s %8s %8s\n", "phase", "seconds",
+        "rss(KiB)", "rss", "timer", "sockets", "epoll", "open", "idle");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    Sample base = sample_(pid, port);
+    print_("baseline", 0, base, base);
+
+    // accepted: the server polls the connections, nothing was sent yet
+    std::vector<int> fds;
+    fds.reserve(options.connections);
+    uint64_t start = Metrics::now();
+    open_connections_(port, options, fds);
+    bool accepted = fds.size() == options.connections
+        && wait_accepted_(port, base, fds.size());
+    double seconds = seconds_since_(start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    print_("accepted", seconds, sample_(pid, port), base);
+
+    // idle: one request on each, then kept alive
+    start = Metrics::now();
+    size_t answered = request_all_(fds);
+    wait_idle_(port, answered);
+    seconds = seconds_since_(start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    Sample idle = sample_(pid, port);
+    print_("idle", seconds, idle, base);
+
+    int exit_code = 0;
+    if (!accepted) {
+        std::printf("\nthe server accepted fewer than %zu connections\n",
+            options.connections);
+        exit_code = 1;
+    }
+    if (answered != options.connections) {
+        std::printf("\n%zu of %zu connections were answered\n", answered,
+            options.connections);
+        exit_code = 1;
+    }
+    double rss = per_(idle.rss, base.rss, held_(idle, base));
+    if (options.max_bytes != 0
+            && rss > static_cast<double>(options.max_bytes)) {
+        std::printf("\n%.0f bytes of RSS per idle connection, more than "
+            "--max-bytes %llu\n", rss,
+            static_cast<unsigned long long>(options.max_bytes));
+        exit_code = 1;
+    }
+    if (!bench::server_alive(pid)) {
+        std::printf("\nserver exited\n");
+        exit_code = 1;
+    }
+
+    for (int fd : fds) ::close(fd);
+    bench::stop_server(pid);
+    ::unlink(page.c_str());
+    ::unlink(conf.c_str());
+    ::rmdir(dir.c_str());
+    return exit_code;
+}
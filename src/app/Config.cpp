@@ -27,11 +27,15 @@
 #include "Config.h"
 
 // C
+#include <climits>
+#include <cstdint>
 #include <cstring>
 
 // C++
+#include <charconv>
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 namespace webstab {
 
@@ -39,6 +43,11 @@ namespace {
 
 const char* DefaultConfName = "webstable.conf";
 
+// 'webstable.conf:12: '
+std::string where_(std::string_view fname, size_t line_num) {
+    return std::string(fname) + ':' + std::to_string(line_num) + ": ";
+}
+
 inline void rm_front_blank_(std::string& s) {
     if (!s.empty()) {
         size_t i = 0, sz = s.size();
@@ -71,9 +80,8 @@ void is_valid_path_(std::filesystem::path& file) {
     } else {
 
         if (!std::filesystem::exists(file)) {
-            std::cerr << "The configuration file or directory "
-                << file << " does not exists" << std::endl;
-            exit(1);
+            throw ConfigError(1, "The configuration file or directory "
+                + file.string() + " does not exists");
         }
 
         // to the simplest path
@@ -85,9 +93,8 @@ void is_valid_path_(std::filesystem::path& file) {
     }
 
     if (!std::filesystem::exists(file)) {
-        std::cerr << "The configuration file " << file
-            << " does not exists" << std::endl;
-        exit(1);
+        throw ConfigError(1, "The configuration file "
+            + file.string() + " does not exists");
     }
 }
 
@@ -107,25 +114,56 @@ void split_keys_(const std::string& key,
     if (start != key.size()) map[key.substr(start)] = value;
 }
 
-using SectionType = enum { Global, Server, Static, Types, Error };
+// a [server] key that is a number, and its range
+struct NumberKey {
+    const char* name;
+    long long min;
+    long long max;
+};
+
+constexpr NumberKey ServerNumbers[] = {
+    { "backlog", 1, 65535 },
+    { "defer_accept", 0, INT_MAX },
+    { "fastopen", 0, INT_MAX },
+    { "max_connections", 0, INT_MAX },
+    { "max_connections_per_ip", 0, INT_MAX },
+    { "max_queue", 0, INT_MAX },
+    { "threads_num", 1, 4096 },
+    { "keepalive", 1, 86400 },
+    { "header_timeout", 1, 86400 },
+    { "gzip_level", 0, 9 },
+    { "gzip_stream_level", 0, 9 },
+    { "gzip_stream_limit", 0, INT_MAX },
+};
+
+// [server] keys that are sizes
+constexpr const char* ServerSizes[] = {
+    "max_body_size",
+    "body_buffer_size",
+    "cache_size",
+    "cache_max_file_size",
+    "gzip_min_length",
+    "access_log_buffer",
+};
+
+using SectionType = enum { Global, Server, Tcp, Static, Types, Error };
 
 SectionType parse_section_(const std::string& line, std::string_view fname, size_t line_num) {
     if (line.back() != ']') {
-        std::cerr << fname << ':' << line_num
-            << ": The closing bracket cannot be found." << std::endl;
-        exit(3);
+        throw ConfigError(3, where_(fname, line_num)
+            + "The closing bracket cannot be found.");
     }
     static std::unordered_map<std::string, SectionType> map = {
         { "[server]", Server },
+        { "[tcp]", Tcp },
         { "[static]", Static },
         { "[error]", Error },
         { "[types]", Types },
     };
     auto it = map.find(line);
     if (it == map.end()) {
-        std::cerr << fname << ':' << line_num
-            << ": Invalid section name." << std::endl;
-        exit(4);
+        throw ConfigError(4, where_(fname, line_num)
+            + "Invalid section name.");
     }
     return it->second;
 }
@@ -134,24 +172,127 @@ SectionType parse_section_(const std::string& line, std::string_view fname, size
 
 Config::Config() : server_({
     { "listen", "0.0.0.0:80" },
+    { "backlog", "511" },
+    { "defer_accept", "0" },
+    { "fastopen", "0" },
+    { "max_connections", "0" },
+    { "max_connections_per_ip", "0" },
+    { "max_queue", "0" },
     { "threads_num", "16" },
     { "keepalive", "30" },
+    { "header_timeout", "10" },
     { "poller", "epoll" },
     { "index", "index.html" },
     { "default_type", "application/octet-stream"},
-    { "server_name", "WebStable" } }) {}
+    { "server_name", "WebStable" },
+    { "max_body_size", "1m" },
+    { "body_buffer_size", "16k" },
+    { "body_temp_path", "/tmp" },
+    { "cache_size", "100m" },
+    { "cache_max_file_size", "1m" },
+    { "gzip_level", "6" },
+    { "gzip_min_length", "256" },
+    { "gzip_types", "text/html text/css text/plain text/xml"
+        " application/javascript application/json application/xml"
+        " image/svg+xml" },
+    { "gzip_stream_level", "1" },
+    { "gzip_stream_limit", "4" },
+    { "status_path", "" },
+    { "status_allow", "127.0.0.1 ::1" },
+    { "access_log", "" },
+    { "access_log_buffer", "64k" },
+    { "access_log_overflow", "drop" } }),
+    tcp_({
+    { "nodelay", "on" },
+    { "sndbuf", "0" },
+    { "rcvbuf", "0" },
+    { "notsent_lowat", "0" },
+    { "linger", "off" } }) {}
+
+size_t Config::parse_size(const std::string& str) {
+    // one set of rules, the values were checked when the file was read
+    return check_size(str, str, SIZE_MAX);
+}
+
+long long Config::check_number(const std::string& key,
+        const std::string& value, long long min, long long max) {
+    long long number = 0;
+    const char* end = value.data() + value.size();
+    auto [p, ec] = std::from_chars(value.data(), end, number);
+    if (value.empty() || ec != std::errc() || p != end
+            || number < min || number > max)
+        throw ConfigError(10, key + ": expected a number from "
+            + std::to_string(min) + " to " + std::to_string(max)
+            + ", got '" + value + "'");
+    return number;
+}
+
+size_t Config::check_size(const std::string& key, const std::string& value,
+        size_t max) {
+    size_t size = 0;
+    const char* end = value.data() + value.size();
+    auto [p, ec] = std::from_chars(value.data(), end, size);
+    int shift = 0;
+    if (ec == std::errc() && p + 1 == end) {
+        switch (*p | 0x20) {
+        case 'k': shift = 10; break;
+        case 'm': shift = 20; break;
+        case 'g': shift = 30; break;
+        default: shift = -1;
+        }
+    } else if (ec != std::errc() || p != end) {
+        shift = -1;
+    }
+    if (value.empty() || shift < 0)
+        throw ConfigError(10, key + ": expected a size such as 512, 16k, "
+            "1m or 2g, got '" + value + "'");
+    if (size > (max >> shift))
+        throw ConfigError(10, key + ": '" + value + "' is larger than "
+            + std::to_string(max) + " bytes");
+    return size << shift;
+}
+
+void Config::check_field_value(const std::string& key,
+        const std::string& value) {
+    if (value.size() > MaxFieldValueLength)
+        throw ConfigError(10, key + ": longer than "
+            + std::to_string(MaxFieldValueLength) + " bytes");
+    for (char c : value) {
+        // a line break would end the header in the middle of the head
+        if ((static_cast<unsigned char>(c) < 0x20 && c != '\t') || c == 0x7f)
+            throw ConfigError(10, key + ": control character in '"
+                + value + "'");
+    }
+}
+
+ConfigError::ConfigError(int code, const std::string& what)
+    : std::runtime_error(what), code_(code) {}
 
 Config::Config(std::filesystem::path file) : Config() {
+    try {
+        parse_(std::move(file));
+    } catch (const ConfigError& e) {
+        std::cerr << e.what() << std::endl;
+        exit(e.code());
+    }
+}
+
+Config Config::load(std::filesystem::path file) {
+    Config config;
+    config.parse_(std::move(file));
+    return config;
+}
+
+void Config::parse_(std::filesystem::path file) {
     is_valid_path_(file);
+    file_ = file;
 
     // read the configuration file
     std::ifstream conf(file, std::ios::in);
     if (conf.fail()) {
         int err = errno;
-        std::cerr << "Read configuration file "
-            << file << " failed: "
-            << std::strerror(err) << std::endl;
-        exit(err);
+        throw ConfigError(err, "Read configuration file "
+            + file.string() + " failed: " + std::strerror(err));
     }
     std::string line;
     size_t line_num = 1;
@@ -171,26 +312,23 @@ Config::Config(std::filesystem::path file) : Config() {
             // key and value
             if (cur == Global) {
                 // in global section
-                std::cerr << file.c_str() << ':' << line_num
-                    << ": Invalid line in global space." << std::endl;
-                exit(5);
+                throw ConfigError(5, where_(file.c_str(), line_num)
+                    + "Invalid line in global space.");
             }
             // in server/static/error section
             size_t pos = line.find_first_of('=');
             if (pos == std::string::npos) {
                 // is not a k-v string
-                std::cerr << file.c_str() << ':' << line_num
-                    << ": This line does not contain key-value" << std::endl;
-                exit(6);
+                throw ConfigError(6, where_(file.c_str(), line_num)
+                    + "This line does not contain key-value");
             }
             // get key-value
             std::string key = line.substr(0, pos), value = line.substr(pos + 1);
             rm_back_blank_(key);
             rm_front_blank_(value);
             if (key.empty()) {
-                std::cerr << file.c_str() << ':' << line_num
-                    << ": Key is empty" << std::endl;
-                exit(7);
+                throw ConfigError(7, where_(file.c_str(), line_num)
+                    + "Key is empty");
             }
 
             // parse
@@ -198,7 +336,18 @@ Config::Config(std::filesystem::path file) : Config() {
             case Server: // [server]
                 this->server_[key] = value;
                 break;
+            case Tcp: // [tcp]
+                if (tcp_.find(key) == tcp_.end()) {
+                    throw ConfigError(9, where_(file.c_str(), line_num)
+                        + "Unknown key in [tcp]");
+                }
+                this->tcp_[key] = value;
+                break;
             case Static: // [static]
+                if (key != "root" && key.front() != '/') {
+                    throw ConfigError(8, where_(file.c_str(), line_num)
+                        + "A mount is 'root' or starts with '/'");
+                }
                 this->static_[key] = value;
                 break;
             case Error: // [error]
@@ -213,10 +362,38 @@ Config::Config(std::filesystem::path file) : Config() {
         ++line_num;
     }
     conf.close();
-    if (this->static_path("root").empty()) {
-        std::cerr << "static path: root is empty" << std::endl;
-        exit(1);
-    }
+    if (this->static_path("root").empty())
+        throw ConfigError(1, "static path: root is empty");
+    check_server_();
+    check_tcp_();
+}
+
+void Config::check_server_() const {
+    // checked once here, the accessors then convert without failing
+    std::string prefix = file_.string() + ": [server] ";
+    for (const NumberKey& key : ServerNumbers)
+        check_number(prefix + key.name, server_.at(key.name),
+            key.min, key.max);
+    for (const char* key : ServerSizes)
+        check_size(prefix + key, server_.at(key), SIZE_MAX);
+    for (const char* key : { "server_name", "default_type" })
+        check_field_value(prefix + key, server_.at(key));
+    for (const auto& [extension, type] : types_)
+        check_field_value(file_.string() + ": [types] " + extension, type);
+}
+
+void Config::check_tcp_() const {
+    std::string prefix = file_.string() + ": [tcp] ";
+    const std::string& nodelay = tcp_.at("nodelay");
+    if (nodelay != "on" && nodelay != "off")
+        throw ConfigError(10, prefix + "nodelay: expected on or off, got '"
+            + nodelay + "'");
+    // set as an int option
+    for (const char* key : { "sndbuf", "rcvbuf", "notsent_lowat" })
+        check_size(prefix + key, tcp_.at(key), INT_MAX);
+    const std::string& linger = tcp_.at("linger");
+    if (linger != "off")
+        check_number(prefix + "linger", linger, 0, 65535);
 }
 
 std::string Config::to_string() const {
@@ -224,6 +401,10 @@ std::string Config::to_string() const {
     for (const auto& [key, value] : this->server_) {
         res += '\t' + key + " = " + value + '\n';
     }
+    res += "\n[tcp]\n";
+    for (const auto& [key, value] : this->tcp_) {
+        res += '\t' + key + " = " + value + '\n';
+    }
     if (!this->static_.empty()) {
         res += "\n[static]\n";
         for (const auto& [path, local] : this->static_)
@@ -259,6 +440,30 @@ std::string Config::server(const std::string& name) const {
     return it->second;
 }
 
+int Config::backlog() const {
+    return std::stoi(server_.at("backlog"));
+}
+
+int Config::defer_accept() const {
+    return std::stoi(server_.at("defer_accept"));
+}
+
+int Config::fastopen() const {
+    return std::stoi(server_.at("fastopen"));
+}
+
+size_t Config::max_connections() const {
+    return std::stoul(server_.at("max_connections"));
+}
+
+size_t Config::max_connections_per_ip() const {
+    return std::stoul(server_.at("max_connections_per_ip"));
+}
+
+size_t Config::max_queue() const {
+    return std::stoul(server_.at("max_queue"));
+}
+
 size_t Config::threads_num() const {
     return std::stoul(server_.at("threads_num"));
 }
@@ -297,4 +502,102 @@ size_t Config::keepalive_timeout() const {
     return std::stoul(it->second);
 }
 
+size_t Config::header_timeout() const {
+    return std::stoul(server_.at("header_timeout"));
+}
+
+size_t Config::max_body_size() const {
+    return parse_size(server_.at("max_body_size"));
+}
+
+size_t Config::body_buffer_size() const {
+    return parse_size(server_.at("body_buffer_size"));
+}
+
+std::string Config::body_temp_path() const {
+    return server_.at("body_temp_path");
+}
+
+size_t Config::cache_size() const {
+    return parse_size(server_.at("cache_size"));
+}
+
+size_t Config::cache_max_file_size() const {
+    return parse_size(server_.at("cache_max_file_size"));
+}
+
+int Config::gzip_level() const {
+    return std::stoi(server_.at("gzip_level"));
+}
+
+size_t Config::gzip_min_length() const {
+    return parse_size(server_.at("gzip_min_length"));
+}
+
+int Config::gzip_stream_level() const {
+    return std::stoi(server_.at("gzip_stream_level"));
+}
+
+size_t Config::gzip_stream_limit() const {
+    return std::stoul(server_.at("gzip_stream_limit"));
+}
+
+std::string Config::status_path() const {
+    return server_.at("status_path");
+}
+
+std::string Config::status_allow() const {
+    return server_.at("status_allow");
+}
+
+std::string Config::access_log() const {
+    return server_.at("access_log");
+}
+
+size_t Config::access_log_buffer() const {
+    return parse_size(server_.at("access_log_buffer"));
+}
+
+std::string Config::access_log_overflow() const {
+    return server_.at("access_log_overflow");
+}
+
+bool Config::tcp_nodelay() const {
+    return tcp_.at("nodelay") == "on";
+}
+
+size_t Config::tcp_sndbuf() const {
+    return parse_size(tcp_.at("sndbuf"));
+}
+
+size_t Config::tcp_rcvbuf() const {
+    return parse_size(tcp_.at("rcvbuf"));
+}
+
+size_t Config::tcp_notsent_lowat() const {
+    return parse_size(tcp_.at("notsent_lowat"));
+}
+
+int Config::tcp_linger() const {
+    const std::string& value = tcp_.at("linger");
+    return value == "off" ? -1 : std::stoi(value);
+}
+
+bool Config::same_tcp(const Config& other) const {
+    return tcp_ == other.tcp_;
+}
+
+bool Config::gzip_type(const std::string& type) const {
+    // 'gzip_types' is a list of MIME types separated by blanks
+    const std::string& types = server_.at("gzip_types");
+    for (size_t pos = types.find(type); pos != std::string::npos;
+            pos = types.find(type, pos + 1)) {
+        size_t end = pos + type.size();
+        if ((pos == 0 || types[pos - 1] == ' ' || types[pos - 1] == '\t')
+            && (end == types.size() || types[end] == ' ' || types[end] == '\t'))
+            return true;
+    }
+    return false;
+}
+
 } // namespace webstab
@@ -31,6 +31,7 @@
 // C++
 #include <unordered_map>
 #include <filesystem>
+#include <stdexcept>
 #include <string>
 
 // nanonet
@@ -38,11 +39,29 @@
 
 namespace webstab {
 
+// a configuration file that cannot be used, 'code' is the exit status
+// when it happens at startup
+class ConfigError : public std::runtime_error {
+    int code_;
+
+public:
+    ConfigError(int code, const std::string& what);
+    inline int code() const noexcept { return code_; }
+
+}; // class ConfigError
+
 class Config {
 
+    // the file it was read from, empty for the defaults
+    std::filesystem::path file_;
+
     // [server]
     std::unordered_map<std::string, std::string> server_;
 
+    // [tcp], options set on the listener and inherited by the accepted
+    // connections
+    std::unordered_map<std::string, std::string> tcp_;
+
     // [static]
     std::unordered_map<std::string, std::filesystem::path> static_;
 
@@ -52,25 +71,121 @@ class Config {
     // [types]
     std::unordered_map<std::string, std::string> types_;
 
+private:
+    void parse_(std::filesystem::path file);
+
+    // throw ConfigError for the first value that cannot be used
+    void check_server_() const;
+    void check_tcp_() const;
+
 public:
     Config();
+
+    // reads 'file', exits with a message when it is invalid
     Config(std::filesystem::path file);
 
+    // reads 'file', throws ConfigError when it is invalid
+    static Config load(std::filesystem::path file);
+
+    // size with an optional unit: 512, 16k, 1m, 2g, as check_size()
+    // reads it
+    static size_t parse_size(const std::string& str);
+
+    // 'value' as a decimal number from 'min' to 'max', or as a size of at
+    // most 'max' bytes. throw ConfigError naming 'key' when it is not
+    static long long check_number(const std::string& key,
+        const std::string& value, long long min, long long max);
+    static size_t check_size(const std::string& key,
+        const std::string& value, size_t max);
+
+    // values copied into response heads, such as server_name, are at
+    // most this long so that every head fits its buffer
+    static constexpr size_t MaxFieldValueLength = 256;
+
+    // 'value' as a field value of a response head, throws ConfigError
+    // naming 'key' when it is too long or holds a control character
+    static void check_field_value(const std::string& key,
+        const std::string& value);
+
     Config(const Config&) = default;
     Config(Config&&) = default;
     
     std::string to_string() const;
+    inline const std::filesystem::path& file() const { return file_; }
 
     nano::AddrPort get_listen() const;
     void set_listen(const nano::AddrPort& addr_port);
     std::string server(const std::string& name) const;
+
+    // length of the queue of connections waiting for accept()
+    int backlog() const;
+
+    // seconds a connection may wait for its first data before it is
+    // accepted, 0 accepts it at once
+    int defer_accept() const;
+
+    // length of the queue of TCP Fast Open requests, 0 turns it off
+    int fastopen() const;
+
+    // connections open at once, in total and from one client address.
+    // those beyond are answered 503 and closed, 0 is no limit
+    size_t max_connections() const;
+    size_t max_connections_per_ip() const;
+
+    // connections waiting for a worker, beyond which a new request is
+    // answered 503 by the main loop. 0 is no limit
+    size_t max_queue() const;
+
     size_t threads_num() const;
     std::string poller() const;
     std::string type(const std::string& extension) const;
+    inline const std::unordered_map<std::string, std::string>& types() const {
+        return types_;
+    }
     std::string server_name() const;
     std::filesystem::path static_path(std::string url_path) const;
+    inline const std::unordered_map<std::string, std::filesystem::path>&
+    statics() const {
+        return static_;
+    }
     size_t keepalive_timeout() const;
 
+    // seconds a request may take to send its head once the worker had to
+    // wait for it, it is then answered 408
+    size_t header_timeout() const;
+
+    size_t max_body_size() const;
+    size_t body_buffer_size() const;
+    std::string body_temp_path() const;
+    size_t cache_size() const;
+    size_t cache_max_file_size() const;
+    int gzip_level() const;
+    size_t gzip_min_length() const;
+    int gzip_stream_level() const;
+    size_t gzip_stream_limit() const;
+    bool gzip_type(const std::string& type) const;
+    std::string status_path() const;
+    std::string status_allow() const;
+    std::string access_log() const;
+    size_t access_log_buffer() const;
+    std::string access_log_overflow() const;
+
+    // 'nodelay', on or off
+    bool tcp_nodelay() const;
+
+    // 'sndbuf' and 'rcvbuf', 0 leaves the buffers to the kernel
+    size_t tcp_sndbuf() const;
+    size_t tcp_rcvbuf() const;
+
+    // 'notsent_lowat', 0 leaves the limit to the kernel
+    size_t tcp_notsent_lowat() const;
+
+    // 'linger' in seconds, -1 when off. 0 resets the connections on close
+    // instead of closing them gracefully
+    int tcp_linger() const;
+
+    bool same_tcp(const Config& other) const;
+
 }; // class Config
 
 } // namespace webstab
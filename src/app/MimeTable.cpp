@@ -0,0 +1,94 @@
+// File:     src/app/MimeTable.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MimeTable.h"
+
+namespace webstab {
+
+namespace {
+
+// tries per table size before the table is doubled
+constexpr uint32_t MaxSeeds = 4096;
+
+// FNV-1a with a seed mixed into the offset basis
+inline size_t hash_(std::string_view s, uint32_t seed) noexcept {
+    uint64_t h = 14695981039346656037ULL ^ seed;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+} // anonymous namespace
+
+size_t MimeTable::slot_(std::string_view extension) const noexcept {
+    return hash_(extension, seed_) & mask_;
+}
+
+MimeTable::MimeTable(const Config& config) {
+    default_.type = config.type("");
+    default_.compressible = config.gzip_type(default_.type);
+
+    const auto& types = config.types();
+    size_t size = 1;
+    while (size < types.size() * 2) size <<= 1;
+    for (;; size <<= 1) {
+        mask_ = size - 1;
+        std::vector<bool> used(size);
+        for (seed_ = 0; seed_ < MaxSeeds; ++seed_) {
+            used.assign(size, false);
+            bool perfect = true;
+            for (const auto& [extension, type] : types) {
+                size_t slot = slot_(extension);
+                if (used[slot]) {
+                    perfect = false;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (perfect) break;
+        }
+        if (seed_ != MaxSeeds) break;
+    }
+
+    slots_.resize(size);
+    for (const auto& [extension, type] : types) {
+        MimeType& mime = slots_[slot_(extension)];
+        mime.extension = extension;
+        mime.type = type;
+        mime.compressible = config.gzip_type(type);
+    }
+}
+
+const MimeType& MimeTable::lookup(
+        std::string_view extension) const noexcept {
+    if (slots_.empty() || extension.empty()) return default_;
+    const MimeType& mime = slots_[slot_(extension)];
+    return mime.extension == extension ? mime : default_;
+}
+
+} // namespace webstab
@@ -0,0 +1,73 @@
+// File:     src/app/MimeTable.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_APP_MIMETABLE_H
+#define WEBSTABLE_APP_MIMETABLE_H
+
+// C++
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// WebStable
+#include "app/Config.h"
+
+namespace webstab {
+
+struct MimeType {
+    std::string extension;
+    std::string type;
+
+    // listed in 'gzip_types'
+    bool compressible = false;
+};
+
+// the [types] of a configuration in a flat open-addressed table. the seed
+// of the hash is searched when the table is built until no two extensions
+// share a slot, so a lookup is one hash and one comparison
+class MimeTable {
+    std::vector<MimeType> slots_;
+    uint32_t seed_ = 0;
+    size_t mask_ = 0;
+    MimeType default_;
+
+private:
+    size_t slot_(std::string_view extension) const noexcept;
+
+public:
+    MimeTable() = default;
+    explicit MimeTable(const Config& config);
+
+    // the type of 'extension' (without the dot), or 'default_type'
+    const MimeType& lookup(std::string_view extension) const noexcept;
+
+}; // class MimeTable
+
+} // namespace webstab
+
+#endif // WEBSTABLE_APP_MIMETABLE_H
@@ -0,0 +1,122 @@
+// File:     src/app/MountTrie.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MountTrie.h"
+
+// C++
+#include <algorithm>
+
+namespace webstab {
+
+namespace {
+
+// the root '/' is the empty prefix, '/docs/' is '/docs'
+std::string_view strip_slash_(std::string_view prefix) {
+    while (!prefix.empty() && prefix.back() == '/')
+        prefix.remove_suffix(1);
+    return prefix;
+}
+
+size_t common_length_(std::string_view a, std::string_view b) {
+    size_t i = 0, n = std::min(a.size(), b.size());
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+} // anonymous namespace
+
+MountTrie::MountTrie() : nodes_(1) {}
+
+void MountTrie::insert(std::string_view prefix, int value) {
+    prefix = strip_slash_(prefix);
+    uint32_t node = 0;
+    while (!prefix.empty()) {
+        // the child whose label starts with the next character
+        uint32_t next = 0;
+        for (uint32_t child : nodes_[node].children) {
+            if (nodes_[child].label.front() == prefix.front()) {
+                next = child;
+                break;
+            }
+        }
+        if (next == 0) {
+            Node leaf;
+            leaf.label = std::string(prefix);
+            leaf.value = value;
+            nodes_.push_back(std::move(leaf));
+            nodes_[node].children.push_back(
+                static_cast<uint32_t>(nodes_.size() - 1));
+            return;
+        }
+
+        size_t common = common_length_(nodes_[next].label, prefix);
+        if (common < nodes_[next].label.size()) {
+            // split the edge at the first differing character
+            Node tail;
+            tail.label = nodes_[next].label.substr(common);
+            tail.value = nodes_[next].value;
+            tail.children.swap(nodes_[next].children);
+            nodes_.push_back(std::move(tail));
+            nodes_[next].label.resize(common);
+            nodes_[next].value = -1;
+            nodes_[next].children.assign(1,
+                static_cast<uint32_t>(nodes_.size() - 1));
+        }
+        prefix.remove_prefix(common);
+        node = next;
+    }
+    nodes_[node].value = value;
+}
+
+int MountTrie::match(std::string_view path, size_t& length) const noexcept {
+    int value = nodes_[0].value;
+    length = 0;
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (pos < path.size()) {
+        uint32_t next = 0;
+        for (uint32_t child : nodes_[node].children) {
+            if (nodes_[child].label.front() == path[pos]) {
+                next = child;
+                break;
+            }
+        }
+        if (next == 0) break;
+        const std::string& label = nodes_[next].label;
+        if (path.compare(pos, label.size(), label) != 0) break;
+        pos += label.size();
+        node = next;
+        // a mount only covers whole segments
+        if (nodes_[node].value != -1
+                && (pos == path.size() || path[pos] == '/')) {
+            value = nodes_[node].value;
+            length = pos;
+        }
+    }
+    return value;
+}
+
+} // namespace webstab
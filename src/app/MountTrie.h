@@ -0,0 +1,65 @@
+// File:     src/app/MountTrie.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_APP_MOUNTTRIE_H
+#define WEBSTABLE_APP_MOUNTTRIE_H
+
+// C++
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace webstab {
+
+// URL prefixes in a radix trie, edges hold whole runs of characters. a
+// lookup walks the path once and keeps the deepest prefix that ends on
+// a segment boundary, so '/assets' matches '/assets/a.css' and '/assets'
+// but not '/assets2'
+class MountTrie {
+    struct Node {
+        std::string label;
+        int value = -1;
+        std::vector<uint32_t> children;
+    };
+    std::vector<Node> nodes_;
+
+public:
+    MountTrie();
+
+    // 'prefix' starts with '/', a trailing '/' is ignored
+    void insert(std::string_view prefix, int value);
+
+    // the value of the longest prefix of 'path', or -1. 'length' is set
+    // to the length of that prefix
+    int match(std::string_view path, size_t& length) const noexcept;
+
+}; // class MountTrie
+
+} // namespace webstab
+
+#endif // WEBSTABLE_APP_MOUNTTRIE_H
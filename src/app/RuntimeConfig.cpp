@@ -0,0 +1,171 @@
+// File:     src/app/RuntimeConfig.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RuntimeConfig.h"
+
+// C
+#include <cstdint>
+
+// C++
+#include <atomic>
+
+namespace webstab {
+
+namespace {
+
+std::atomic<uint64_t> generations_ { 0 };
+
+std::string_view trim_(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// the directory and the '; key=value' options after it
+Mount parse_mount_(const std::string& key, const std::string& value,
+        const Config& config, const CachePolicy& defaults) {
+    Mount mount;
+    mount.prefix = key == "root" ? "/" : key;
+    mount.index = config.server("index");
+    mount.cache_policy = defaults;
+
+    std::string_view rest = value;
+    size_t semicolon = rest.find(';');
+    mount.dir = std::string(trim_(rest.substr(0, semicolon)));
+    while (mount.dir.size() > 1 && mount.dir.back() == '/')
+        mount.dir.pop_back();
+    while (semicolon != std::string_view::npos) {
+        rest.remove_prefix(semicolon + 1);
+        semicolon = rest.find(';');
+        std::string_view option = trim_(rest.substr(0, semicolon));
+        if (option.empty()) continue;
+        size_t equal = option.find('=');
+        std::string name(trim_(option.substr(0, equal)));
+        std::string arg(equal == std::string_view::npos
+            ? std::string_view() : trim_(option.substr(equal + 1)));
+        std::string where = "static path " + key + ": " + name;
+        if (name == "index") {
+            mount.index = arg;
+        } else if (name == "cache_control") {
+            Config::check_field_value(where, arg);
+            mount.cache_control = arg;
+        } else if (name == "cache_max_file_size") {
+            mount.cache_policy.max_file_size =
+                Config::check_size(where, arg, SIZE_MAX);
+        } else if (name == "gzip_level") {
+            mount.cache_policy.gzip_level =
+                static_cast<int>(Config::check_number(where, arg, 0, 9));
+        } else if (name == "gzip_min_length") {
+            mount.cache_policy.gzip_min_length =
+                Config::check_size(where, arg, SIZE_MAX);
+        } else {
+            throw ConfigError(8, "static path " + key
+                + ": unknown option '" + name + "'");
+        }
+    }
+    if (mount.dir.empty())
+        throw ConfigError(1, "static path: " + key + " is empty");
+    return mount;
+}
+
+} // anonymous namespace
+
+RuntimeConfig::RuntimeConfig(const Config& config)
+        : generation_(++generations_),
+        server_name_(config.server_name()),
+        keepalive_timeout_(config.keepalive_timeout()),
+        keepalive_ms_(static_cast<int>(keepalive_timeout_ * 1000)),
+        header_timeout_ns_(config.header_timeout() * 1000000000UL),
+        gzip_stream_level_(config.gzip_stream_level()),
+        gzip_stream_limit_(config.gzip_stream_limit()),
+        status_path_(config.status_path()),
+        cache_size_(config.cache_size()),
+        types_(config) {
+    body_policy_.max_size = config.max_body_size();
+    body_policy_.buffer_size = config.body_buffer_size();
+    body_policy_.temp_path = config.body_temp_path();
+
+    // 'status_allow' is a list of addresses separated by blanks
+    std::string_view allow = config.status_allow();
+    while (!allow.empty()) {
+        size_t blank = allow.find_first_of(" \t");
+        if (blank != 0)
+            status_allow_.emplace_back(allow.substr(0, blank));
+        if (blank == std::string_view::npos) break;
+        allow.remove_prefix(blank + 1);
+    }
+
+    CachePolicy defaults;
+    defaults.max_file_size = config.cache_max_file_size();
+    defaults.gzip_level = config.gzip_level();
+    defaults.gzip_min_length = config.gzip_min_length();
+    for (const auto& [key, value] : config.statics()) {
+        mounts_.push_back(parse_mount_(key, value.string(), config, defaults));
+        routes_.insert(mounts_.back().prefix,
+            static_cast<int>(mounts_.size() - 1));
+    }
+}
+
+bool RuntimeConfig::status_allowed(
+        std::string_view address) const noexcept {
+    // an IPv4 peer of a dual-stack socket is '::ffff:127.0.0.1'
+    if (address.compare(0, 7, "::ffff:") == 0
+            && address.find('.') != std::string_view::npos)
+        address.remove_prefix(7);
+    for (const std::string& allowed : status_allow_)
+        if (allowed == address) return true;
+    return false;
+}
+
+const Mount* RuntimeConfig::route(std::string_view path,
+        std::string_view& rest) const noexcept {
+    size_t length = 0;
+    int mount = routes_.match(path, length);
+    if (mount == -1) return nullptr;
+    rest = path.substr(length);
+    return &mounts_[mount];
+}
+
+bool RuntimeConfig::same_files(const RuntimeConfig& other) const noexcept {
+    if (mounts_.size() != other.mounts_.size()) return false;
+    for (const Mount& mount : mounts_) {
+        std::string_view rest;
+        const Mount* same = other.route(mount.prefix, rest);
+        if (same == nullptr || same->prefix != mount.prefix
+            || same->dir != mount.dir
+            || same->cache_policy.max_file_size
+                != mount.cache_policy.max_file_size
+            || same->cache_policy.gzip_level != mount.cache_policy.gzip_level
+            || same->cache_policy.gzip_min_length
+                != mount.cache_policy.gzip_min_length)
+            return false;
+    }
+    return true;
+}
+
+} // namespace webstab
@@ -0,0 +1,125 @@
+// File:     src/app/RuntimeConfig.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_APP_RUNTIMECONFIG_H
+#define WEBSTABLE_APP_RUNTIMECONFIG_H
+
+// C++
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// WebStable
+#include "app/Config.h"
+#include "app/MimeTable.h"
+#include "app/MountTrie.h"
+#include "file/FileCache.h"
+#include "http/RequestBody.h"
+
+namespace webstab {
+
+// a '[static]' entry, 'root = /srv/www' is the mount of '/'. options
+// follow the directory: '/docs = /srv/docs; index=README.html;
+// cache_control=max-age=600; cache_max_file_size=0; gzip_level=0'
+struct Mount {
+    std::string prefix;
+    std::string dir;
+    std::string index;
+    std::string cache_control;
+    CachePolicy cache_policy;
+};
+
+// a Config compiled once into typed values, read by the request path by
+// reference. never modified after construction
+class RuntimeConfig {
+    // distinguishes the snapshots of one process, never reused
+    uint64_t generation_;
+
+    std::string server_name_;
+
+    // directories without a trailing '/', the rest of a request path
+    // after the prefix is appended
+    std::vector<Mount> mounts_;
+    MountTrie routes_;
+
+    size_t keepalive_timeout_;
+    int keepalive_ms_;
+    uint64_t header_timeout_ns_;
+
+    int gzip_stream_level_;
+    size_t gzip_stream_limit_;
+
+    // the metrics endpoint, empty when disabled, and the peer addresses
+    // it is served to
+    std::string status_path_;
+    std::vector<std::string> status_allow_;
+
+    BodyPolicy body_policy_;
+    size_t cache_size_;
+    MimeTable types_;
+
+public:
+    explicit RuntimeConfig(const Config& config);
+
+    // non-copyable
+    RuntimeConfig(const RuntimeConfig&) = delete;
+    RuntimeConfig& operator=(const RuntimeConfig&) = delete;
+
+    inline uint64_t generation() const { return generation_; }
+    inline const std::string& server_name() const { return server_name_; }
+    inline size_t keepalive_timeout() const { return keepalive_timeout_; }
+    inline int keepalive_ms() const { return keepalive_ms_; }
+    inline uint64_t header_timeout_ns() const { return header_timeout_ns_; }
+    inline int gzip_stream_level() const { return gzip_stream_level_; }
+    inline size_t gzip_stream_limit() const { return gzip_stream_limit_; }
+    inline const std::string& status_path() const { return status_path_; }
+
+    // whether the metrics endpoint is served to the peer at 'address'
+    bool status_allowed(std::string_view address) const noexcept;
+    inline const BodyPolicy& body_policy() const { return body_policy_; }
+    inline size_t cache_size() const { return cache_size_; }
+    inline const std::vector<Mount>& mounts() const { return mounts_; }
+
+    // the mount serving 'path', nullptr when none does. 'rest' is set
+    // to what follows its prefix
+    const Mount* route(std::string_view path,
+        std::string_view& rest) const noexcept;
+
+    // the same directories loaded under the same policies
+    bool same_files(const RuntimeConfig& other) const noexcept;
+
+    // the type of 'extension' (without the dot)
+    inline const MimeType& type(std::string_view extension) const {
+        return types_.lookup(extension);
+    }
+
+}; // class RuntimeConfig
+
+} // namespace webstab
+
+#endif // WEBSTABLE_APP_RUNTIMECONFIG_H
@@ -0,0 +1,361 @@
+// File:     src/core/AccessLog.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "AccessLog.h"
+
+// C
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+// Linux
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// WebStable
+#include "core/Metrics.h"
+
+namespace webstab {
+
+namespace {
+
+// a line longer than this is cut, its fields are shortened first
+constexpr size_t MaxLineLength = 2048;
+
+// the longest a field is kept, the request line and the user agent
+constexpr size_t MaxFieldLength = 512;
+
+// the writer flushes at least this often
+constexpr int FlushIntervalMs = 100;
+
+// '[10/Oct/2000:13:55:36 +0000]', formatted once per second per thread
+struct TimeCache {
+    std::time_t second = -1;
+    char text[32];
+    size_t length = 0;
+};
+
+thread_local TimeCache time_cache_;
+
+std::string_view log_time_() noexcept {
+    timespec now {};
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    if (now.tv_sec != time_cache_.second) {
+        std::tm tm {};
+        ::gmtime_r(&now.tv_sec, &tm);
+        time_cache_.length = std::strftime(time_cache_.text,
+            sizeof(time_cache_.text), "[%d/%b/%Y:%H:%M:%S +0000]", &tm);
+        time_cache_.second = now.tv_sec;
+    }
+    return std::string_view(time_cache_.text, time_cache_.length);
+}
+
+// appends to a line on the stack, what does not fit is cut
+class LineWriter {
+    char* p_;
+    char* end_;
+
+public:
+    LineWriter(char* buf, size_t capacity) : p_(buf), end_(buf + capacity) {}
+
+    inline char* end() const { return p_; }
+
+    void put(std::string_view s) {
+        size_t n = std::min(s.size(), static_cast<size_t>(end_ - p_));
+        std::memcpy(p_, s.data(), n);
+        p_ += n;
+    }
+
+    void put(char c) {
+        if (p_ != end_) *p_++ = c;
+    }
+
+    void put(uint64_t value) {
+        char digits[20];
+        char* p = digits + sizeof(digits);
+        do {
+            *--p = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        put(std::string_view(p, digits + sizeof(digits) - p));
+    }
+
+    // 's' with quotes, control bytes and backslashes as '\xHH'
+    void escaped(std::string_view s) {
+        static constexpr char hex[] = "0123456789abcdef";
+        for (char c : s.substr(0, MaxFieldLength)) {
+            unsigned char u = static_cast<unsigned char>(c);
+            if (u < 0x20 || u >= 0x7f || c == '"' || c == '\\') {
+                char escaped[4] = { '\\', 'x', hex[u >> 4], hex[u & 15] };
+                put(std::string_view(escaped, 4));
+            } else {
+                put(c);
+            }
+        }
+    }
+
+    // 's' escaped in quotes, '"-"' when it is empty
+    void quoted(std::string_view s) {
+        if (s.empty()) {
+            put("\"-\"");
+            return;
+        }
+        put('"');
+        escaped(s);
+        put('"');
+    }
+};
+
+} // anonymous namespace
+
+AccessLog::AccessLog(std::string path, size_t ring_size, Overflow overflow)
+        : path_(std::move(path)), overflow_(overflow) {
+    // a power of two that holds at least a few lines
+    ring_size_ = 4 * MaxLineLength;
+    while (ring_size_ < ring_size) ring_size_ <<= 1;
+
+    if (!open_())
+        throw std::runtime_error("open " + path_ + ": "
+            + std::strerror(errno));
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ == -1) {
+        ::close(fd_);
+        throw std::runtime_error(std::string("eventfd: ")
+            + std::strerror(errno));
+    }
+    writer_ = std::thread([this]() { run_(); });
+}
+
+AccessLog::~AccessLog() {
+    // the writer empties the rings once more before it returns
+    running_.store(false, std::memory_order_relaxed);
+    wake_();
+    if (writer_.joinable()) writer_.join();
+    ::close(wake_fd_);
+    ::close(fd_);
+}
+
+AccessLog::Ring* AccessLog::attach_() {
+    std::unique_ptr<Ring> ring(new Ring);
+    ring->data.reset(new char[ring_size_]);
+    ring->mask = ring_size_ - 1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.push_back(std::move(ring));
+    return rings_.back().get();
+}
+
+void AccessLog::wake_() noexcept {
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t ret = ::write(wake_fd_, &one, sizeof(one));
+}
+
+bool AccessLog::open_() noexcept {
+    int fd = ::open(path_.c_str(),
+        O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return false;
+    if (fd_ != -1) ::close(fd_);
+    fd_ = fd;
+    return true;
+}
+
+void AccessLog::flush_() noexcept {
+    // the rings are only added to, those attached later wait for the
+    // next flush
+    std::vector<Ring*> rings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings.reserve(rings_.size());
+        for (const auto& ring : rings_) rings.push_back(ring.get());
+    }
+
+    // two slices for each ring, the second when it wraps around
+    iovec iov[IOV_MAX];
+    size_t begin = 0;
+    while (begin < rings.size()) {
+        size_t end = std::min(rings.size(), begin + IOV_MAX / 2);
+        size_t count = 0;
+        std::vector<size_t> heads(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            Ring& ring = *rings[i];
+            size_t head = ring.head.load(std::memory_order_acquire);
+            size_t tail = ring.tail.load(std::memory_order_relaxed);
+            heads[i - begin] = head;
+            if (head == tail) continue;
+            size_t from = tail & ring.mask;
+            size_t length = head - tail;
+            size_t first = std::min(length, ring_size_ - from);
+            iov[count++] = { ring.data.get() + from, first };
+            if (first < length)
+                iov[count++] = { ring.data.get(), length - first };
+        }
+
+        // a failed write loses the lines, the workers must not stall
+        iovec* next = iov;
+        while (count) {
+            ssize_t ret = ::writev(fd_, next, static_cast<int>(count));
+            if (ret == -1 && errno == EINTR) continue;
+            if (ret <= 0) break;
+            size_t written = static_cast<size_t>(ret);
+            while (count && written >= next->iov_len) {
+                written -= next->iov_len;
+                ++next;
+                --count;
+            }
+            if (count) {
+                next->iov_base = static_cast<char*>(next->iov_base) + written;
+                next->iov_len -= written;
+            }
+        }
+        for (size_t i = begin; i < end; ++i)
+            rings[i]->tail.store(heads[i - begin], std::memory_order_release);
+        begin = end;
+    }
+}
+
+void AccessLog::run_() noexcept {
+    pollfd pfd { wake_fd_, POLLIN, 0 };
+    while (running_.load(std::memory_order_relaxed)) {
+        if (::poll(&pfd, 1, FlushIntervalMs) > 0) {
+            uint64_t wakes;
+            [[maybe_unused]] ssize_t ret =
+                ::read(wake_fd_, &wakes, sizeof(wakes));
+        }
+        if (reopen_.exchange(false, std::memory_order_relaxed)) {
+            // the lines buffered so far belong to the old file
+            flush_();
+            if (!open_())
+                std::cerr << "Reopen access log " << path_ << " failed: "
+                    << std::strerror(errno) << std::endl;
+        }
+        flush_();
+    }
+    flush_();
+}
+
+void AccessLog::log(const char* peer, const HttpRequest& request,
+        int status, size_t bytes, uint64_t micros) noexcept {
+    char line[MaxLineLength];
+    LineWriter writer(line, sizeof(line) - 1);
+    writer.put(peer);
+    writer.put(" - - ");
+    writer.put(log_time_());
+    writer.put(' ');
+    if (request.method.empty()) {
+        writer.put("\"-\"");
+    } else {
+        writer.put('"');
+        writer.escaped(request.method);
+        writer.put(' ');
+        writer.escaped(request.path);
+        writer.put(' ');
+        writer.escaped(request.version);
+        writer.put('"');
+    }
+    writer.put(' ');
+    writer.put(static_cast<uint64_t>(status));
+    writer.put(' ');
+    writer.put(static_cast<uint64_t>(bytes));
+    writer.put(' ');
+    writer.quoted(request.header(HeaderReferer));
+    writer.put(' ');
+    writer.quoted(request.header(HeaderUserAgent));
+    writer.put(' ');
+    writer.put(micros);
+    size_t length = static_cast<size_t>(writer.end() - line);
+    line[length++] = '\n';
+
+    Ring* ring = local_;
+    if (ring == nullptr || owner_ != this) {
+        try {
+            ring = local_ = attach_();
+            owner_ = this;
+        } catch (...) {
+            Metrics::add(Counter::AccessLogDrops);
+            return;
+        }
+    }
+
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    while (ring_size_ - (head - tail) < length) {
+        if (overflow_ == Overflow::Drop) {
+            Metrics::add(Counter::AccessLogDrops);
+            wake_();
+            return;
+        }
+        // the writer is behind, wait for it to make room
+        wake_();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        tail = ring->tail.load(std::memory_order_acquire);
+    }
+    size_t from = head & ring->mask;
+    size_t first = std::min(length, ring_size_ - from);
+    std::memcpy(ring->data.get() + from, line, first);
+    std::memcpy(ring->data.get(), line + first, length - first);
+    ring->head.store(head + length, std::memory_order_release);
+
+    // the writer is woken early when the ring gets half full
+    size_t half = ring_size_ / 2;
+    if (head - tail < half && head + length - tail >= half)
+        wake_();
+}
+
+void AccessLog::reopen() noexcept {
+    int saved_errno = errno;
+    reopen_.store(true, std::memory_order_relaxed);
+    wake_();
+    errno = saved_errno;
+}
+
+void AccessLog::peer_name(int sock, char (&peer)[PeerNameLength]) noexcept {
+    sockaddr_storage addr {};
+    socklen_t length = sizeof(addr);
+    const void* ip = nullptr;
+    if (::getpeername(sock, reinterpret_cast<sockaddr*>(&addr), &length) == 0) {
+        if (addr.ss_family == AF_INET)
+            ip = &reinterpret_cast<sockaddr_in*>(&addr)->sin_addr;
+        else if (addr.ss_family == AF_INET6)
+            ip = &reinterpret_cast<sockaddr_in6*>(&addr)->sin6_addr;
+    }
+    if (ip == nullptr || !::inet_ntop(addr.ss_family, ip, peer, sizeof(peer)))
+        std::strcpy(peer, "-");
+}
+
+} // namespace webstab
@@ -0,0 +1,122 @@
+// File:     src/core/AccessLog.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_ACCESSLOG_H
+#define WEBSTABLE_CORE_ACCESSLOG_H
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// WebStable
+#include "http/HttpRequest.h"
+
+namespace webstab {
+
+// length of the text form of an IPv6 address and its terminator
+constexpr size_t PeerNameLength = 46;
+
+// an access log in the combined format, with the time taken in
+// microseconds at the end of each line. workers append to a ring buffer
+// of their own, a writer thread empties every ring into the file with one
+// writev() at a time
+class AccessLog final {
+public:
+    // what a worker does when its ring is full
+    enum class Overflow { Drop, Block };
+
+private:
+    // written by one worker and read by the writer. positions only grow,
+    // the bytes of a position are at 'position & mask'
+    struct Ring {
+        alignas(64) std::atomic<size_t> head { 0 };
+        alignas(64) std::atomic<size_t> tail { 0 };
+        std::unique_ptr<char[]> data;
+        size_t mask = 0;
+    };
+
+    std::string path_;
+    size_t ring_size_;
+    Overflow overflow_;
+
+    // the file, used and reopened only by the writer
+    int fd_ = -1;
+
+    // wakes the writer before its next periodic flush
+    int wake_fd_ = -1;
+    std::atomic<bool> reopen_ { false };
+    std::atomic<bool> running_ { true };
+
+    // rings of every worker that logged, never freed before the log
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::thread writer_;
+
+    // the ring of the calling thread, for the log it was attached to
+    static inline thread_local Ring* local_ = nullptr;
+    static inline thread_local const AccessLog* owner_ = nullptr;
+
+private:
+    Ring* attach_();
+    void wake_() noexcept;
+    bool open_() noexcept;
+    void flush_() noexcept;
+    void run_() noexcept;
+
+public:
+    // opens 'path' for appending, throws std::runtime_error when it
+    // cannot. 'ring_size' bytes are buffered per worker thread
+    AccessLog(std::string path, size_t ring_size, Overflow overflow);
+    ~AccessLog();
+
+    // non-copyable
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    // one line for 'request', answered with 'status' and 'bytes' in
+    // 'micros'. dropped and counted when the ring is full, unless the
+    // log blocks
+    void log(const char* peer, const HttpRequest& request, int status,
+        size_t bytes, uint64_t micros) noexcept;
+
+    // the file is reopened by the writer, after it was moved aside.
+    // async-signal-safe
+    void reopen() noexcept;
+
+    // the address of the peer of 'sock' into 'peer', '-' when unknown
+    static void peer_name(int sock, char (&peer)[PeerNameLength]) noexcept;
+
+}; // class AccessLog
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_ACCESSLOG_H
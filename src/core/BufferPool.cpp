@@ -0,0 +1,117 @@
+// File:     src/core/BufferPool.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "BufferPool.h"
+
+// C
+#include <cstdlib>
+
+// C++
+#include <new>
+
+// WebStable
+#include "core/Metrics.h"
+
+namespace webstab {
+
+namespace {
+
+// a free buffer links to the next one in its own first bytes
+struct FreeBuffer {
+    FreeBuffer* next;
+};
+
+struct FreeList {
+    FreeBuffer* head = nullptr;
+    size_t count = 0;
+};
+
+// the free lists of one thread, returned to malloc when it exits
+struct ThreadCache {
+    FreeList lists[BufferClassCount];
+
+    ~ThreadCache() {
+        for (FreeList& list : lists) {
+            while (list.head != nullptr) {
+                FreeBuffer* buffer = list.head;
+                list.head = buffer->next;
+                std::free(buffer);
+            }
+        }
+    }
+};
+
+thread_local ThreadCache cache_;
+
+// the smallest class of at least 'n' bytes, BufferClassCount if none
+size_t class_of_(size_t n) noexcept {
+    size_t i = 0;
+    while (i < BufferClassCount && BufferClasses[i] < n) ++i;
+    return i;
+}
+
+} // anonymous namespace
+
+char* BufferPool::acquire(size_t n, size_t& capacity) {
+    size_t index = class_of_(n);
+    if (index < BufferClassCount) {
+        FreeList& list = cache_.lists[index];
+        capacity = BufferClasses[index];
+        if (list.head != nullptr) {
+            FreeBuffer* buffer = list.head;
+            list.head = buffer->next;
+            --list.count;
+            Metrics::add(Counter::BufferReuses);
+            return reinterpret_cast<char*>(buffer);
+        }
+    } else {
+        capacity = n;
+    }
+    char* data = static_cast<char*>(std::malloc(capacity));
+    if (data == nullptr) throw std::bad_alloc();
+    Metrics::add(Counter::BufferAllocations);
+    return data;
+}
+
+void BufferPool::release(char* data, size_t capacity) noexcept {
+    if (data == nullptr) return;
+    size_t index = class_of_(capacity);
+    if (index == BufferClassCount || BufferClasses[index] != capacity) {
+        std::free(data);
+        return;
+    }
+    FreeList& list = cache_.lists[index];
+    if ((list.count + 1) * capacity > BufferCacheBytes) {
+        std::free(data);
+        return;
+    }
+    FreeBuffer* buffer = reinterpret_cast<FreeBuffer*>(data);
+    buffer->next = list.head;
+    list.head = buffer;
+    ++list.count;
+}
+
+} // namespace webstab
@@ -0,0 +1,64 @@
+// File:     src/core/BufferPool.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_BUFFERPOOL_H
+#define WEBSTABLE_CORE_BUFFERPOOL_H
+
+// C++
+#include <cstddef>
+
+namespace webstab {
+
+// size classes of the pooled buffers, each four times the one before
+constexpr size_t BufferClasses[] = { 4096, 16384, 65536 };
+constexpr size_t BufferClassCount =
+    sizeof(BufferClasses) / sizeof(BufferClasses[0]);
+
+// bytes of each class a thread keeps for reuse, the buffers released
+// beyond it go back to malloc
+constexpr size_t BufferCacheBytes = 256 * 1024;
+
+// receive buffers, recycled through free lists of the thread releasing
+// them. a worker takes a buffer for one turn of a connection and gives it
+// back when the connection goes idle, so the buffers held follow the
+// requests in flight and not the connections open
+class BufferPool final {
+public:
+    BufferPool() = delete;
+
+    // a buffer of at least 'n' bytes, its size is set in 'capacity'.
+    // more than the largest class is allocated to the byte
+    static char* acquire(size_t n, size_t& capacity);
+
+    // gives back a buffer of acquire() with its 'capacity'
+    static void release(char* data, size_t capacity) noexcept;
+
+}; // class BufferPool
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_BUFFERPOOL_H
@@ -0,0 +1,90 @@
+// File:     src/core/ConnectionLimiter.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ConnectionLimiter.h"
+
+// C
+#include <cstring>
+
+// Linux
+#include <netinet/in.h>
+
+namespace webstab {
+
+ConnectionLimiter::Peer ConnectionLimiter::peer_(
+        const sockaddr_storage& addr) noexcept {
+    unsigned char bytes[16] {};
+    if (addr.ss_family == AF_INET6) {
+        const auto& in6 = reinterpret_cast<const sockaddr_in6&>(addr);
+        std::memcpy(bytes, &in6.sin6_addr, 16);
+    } else if (addr.ss_family == AF_INET) {
+        const auto& in = reinterpret_cast<const sockaddr_in&>(addr);
+        bytes[10] = bytes[11] = 0xff;
+        std::memcpy(bytes + 12, &in.sin_addr, 4);
+    }
+    Peer peer;
+    std::memcpy(&peer.high, bytes, 8);
+    std::memcpy(&peer.low, bytes + 8, 8);
+    return peer;
+}
+
+ConnectionLimiter::ConnectionLimiter(size_t max_total, size_t max_per_peer)
+    : max_total_(max_total), max_per_peer_(max_per_peer) {}
+
+bool ConnectionLimiter::admit(int sock, const sockaddr_storage& addr) {
+    if (!max_total_ && !max_per_peer_) return true;
+    size_t index = static_cast<size_t>(sock);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_total_ && open_.load(std::memory_order_relaxed) >= max_total_)
+        return false;
+    if (counted_.size() <= index) counted_.resize(index + 1);
+    if (max_per_peer_) {
+        Peer peer = peer_(addr);
+        size_t& count = per_peer_[peer];
+        if (count >= max_per_peer_) return false;
+        ++count;
+        if (peer_of_.size() <= index) peer_of_.resize(index + 1);
+        peer_of_[index] = peer;
+    }
+    counted_[index] = true;
+    open_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ConnectionLimiter::release(int sock) noexcept {
+    if (!max_total_ && !max_per_peer_) return;
+    size_t index = static_cast<size_t>(sock);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= counted_.size() || !counted_[index]) return;
+    counted_[index] = false;
+    open_.fetch_sub(1, std::memory_order_relaxed);
+    if (!max_per_peer_) return;
+    auto it = per_peer_.find(peer_of_[index]);
+    if (it != per_peer_.end() && --it->second == 0)
+        per_peer_.erase(it);
+}
+
+} // namespace webstab
@@ -0,0 +1,101 @@
+// File:     src/core/ConnectionLimiter.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_CONNECTIONLIMITER_H
+#define WEBSTABLE_CORE_CONNECTIONLIMITER_H
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Linux
+#include <sys/socket.h>
+
+namespace webstab {
+
+// counts the open connections, in total and by client address, and
+// turns away those beyond the limits. a limit of 0 is no limit
+class ConnectionLimiter {
+    // an IPv4 or IPv6 address, IPv4 in its mapped form
+    struct Peer {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        inline bool operator==(const Peer& other) const noexcept {
+            return high == other.high && low == other.low;
+        }
+    };
+
+    struct PeerHash {
+        inline size_t operator()(const Peer& peer) const noexcept {
+            return std::hash<uint64_t>()(peer.high * 0x9e3779b97f4a7c15ULL
+                ^ peer.low);
+        }
+    };
+
+    size_t max_total_;
+    size_t max_per_peer_;
+    std::atomic<size_t> open_ = 0;
+
+    // by client address, and for each socket whether it is counted and
+    // the address it is counted under. the flag makes a second release
+    // of the same socket harmless
+    std::mutex mutex_;
+    std::unordered_map<Peer, size_t, PeerHash> per_peer_;
+    std::vector<bool> counted_;
+    std::vector<Peer> peer_of_;
+
+private:
+    static Peer peer_(const sockaddr_storage& addr) noexcept;
+
+public:
+    ConnectionLimiter(size_t max_total, size_t max_per_peer);
+
+    // non-copyable
+    ConnectionLimiter(const ConnectionLimiter&) = delete;
+    ConnectionLimiter& operator=(const ConnectionLimiter&) = delete;
+
+    // counts 'sock', accepted from 'addr'. false when it is beyond a
+    // limit, it is then not counted
+    bool admit(int sock, const sockaddr_storage& addr);
+
+    // 'sock' is about to be closed, does nothing unless it is counted
+    void release(int sock) noexcept;
+
+    inline size_t open() const noexcept {
+        return open_.load(std::memory_order_relaxed);
+    }
+
+}; // class ConnectionLimiter
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_CONNECTIONLIMITER_H
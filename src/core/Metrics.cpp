@@ -0,0 +1,252 @@
+// File:     src/core/Metrics.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Metrics.h"
+
+// C
+#include <cmath>
+#include <cstdio>
+
+// C++
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace webstab {
+
+namespace {
+
+struct CounterInfo {
+    const char* name;
+    const char* label;
+    const char* help;
+};
+
+// by Counter, the counters sharing a name follow each other
+constexpr CounterInfo CounterInfos[CounterCount] = {
+    { "webstable_requests_total", nullptr, "Requests received." },
+    { "webstable_received_bytes_total", nullptr,
+        "Bytes received from clients." },
+    { "webstable_sent_bytes_total", nullptr, "Bytes sent to clients." },
+    { "webstable_responses_total", "code=\"1xx\"",
+        "Responses by status class." },
+    { "webstable_responses_total", "code=\"2xx\"", nullptr },
+    { "webstable_responses_total", "code=\"3xx\"", nullptr },
+    { "webstable_responses_total", "code=\"4xx\"", nullptr },
+    { "webstable_responses_total", "code=\"5xx\"", nullptr },
+    { "webstable_cache_hits_total", nullptr,
+        "Files found up to date in the cache." },
+    { "webstable_cache_misses_total", nullptr,
+        "Files loaded because they were missing or outdated." },
+    { "webstable_cache_evictions_total", nullptr,
+        "Files evicted from the cache for room." },
+    { "webstable_buffer_reuses_total", nullptr,
+        "Receive buffers taken from a free list." },
+    { "webstable_buffer_allocations_total", nullptr,
+        "Receive buffers allocated because no free one was left." },
+    { "webstable_access_log_dropped_total", nullptr,
+        "Access log lines dropped while the writer was behind." },
+    { "webstable_connections_accepted_total", nullptr,
+        "Connections accepted." },
+    { "webstable_connections_closed_total", nullptr,
+        "Connections closed." },
+    { "webstable_connections_shed_total", nullptr,
+        "Connections answered 503 and closed while overloaded." },
+};
+
+constexpr const char* StageNames[StageCount] = {
+    "loop", "queue", "parse", "respond", "flush",
+};
+
+constexpr double Quantiles[] = { 0.5, 0.99, 0.999 };
+
+struct Gauge {
+    std::string name;
+    std::string help;
+    Metrics::gauge_t read;
+};
+
+// blocks of every thread that counted, and the registered gauges
+std::mutex mutex_;
+std::vector<std::unique_ptr<CounterBlock>> blocks_;
+std::vector<std::unique_ptr<LatencyBlock>> latency_blocks_;
+std::vector<Gauge> gauges_;
+
+void write_help_(std::string& out, const char* name, const char* help,
+        const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void write_value_(std::string& out, const char* name, const char* label,
+        uint64_t value) {
+    out += name;
+    if (label != nullptr) {
+        out += '{';
+        out += label;
+        out += '}';
+    }
+    out += ' ';
+    out += std::to_string(value);
+    out += '\n';
+}
+
+void write_seconds_(std::string& out, const char* name, const char* label,
+        uint64_t ns) {
+    char buf[128];
+    int len = std::snprintf(buf, sizeof(buf), "%s{%s} %.9f\n", name, label,
+        static_cast<double>(ns) / 1e9);
+    if (len > 0 && static_cast<size_t>(len) < sizeof(buf))
+        out.append(buf, static_cast<size_t>(len));
+}
+
+} // anonymous namespace
+
+CounterBlock* Metrics::attach_() {
+    // threads are created once at startup, so the blocks are never freed
+    std::unique_ptr<CounterBlock> block(new CounterBlock{});
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.push_back(std::move(block));
+    return blocks_.back().get();
+}
+
+LatencyBlock* Metrics::attach_latency_() {
+    std::unique_ptr<LatencyBlock> block(new LatencyBlock{});
+    std::lock_guard<std::mutex> lock(mutex_);
+    latency_blocks_.push_back(std::move(block));
+    return latency_blocks_.back().get();
+}
+
+uint64_t Metrics::quantile(const uint64_t* buckets, uint64_t count,
+        double q) noexcept {
+    uint64_t rank = static_cast<uint64_t>(
+        std::ceil(q * static_cast<double>(count)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LatencyBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return bucket_max(i);
+    }
+    return bucket_max(LatencyBuckets - 1);
+}
+
+void Metrics::add_status(int status) noexcept {
+    if (status < 100 || status > 599) return;
+    add(static_cast<Counter>(static_cast<unsigned>(Counter::Status1xx)
+        + static_cast<unsigned>(status / 100 - 1)));
+}
+
+void Metrics::add_gauge(std::string name, std::string help, gauge_t read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.push_back({ std::move(name), std::move(help), std::move(read) });
+}
+
+void Metrics::clear_gauges() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.clear();
+}
+
+void Metrics::expose(std::string& out) {
+    uint64_t totals[CounterCount] = {};
+    std::vector<uint64_t> buckets(StageCount * LatencyBuckets);
+    uint64_t counts[StageCount] = {};
+    uint64_t sums[StageCount] = {};
+    std::vector<Gauge> gauges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& block : blocks_)
+            for (size_t i = 0; i < CounterCount; ++i)
+                totals[i] += block->values[i].load(std::memory_order_relaxed);
+        for (const auto& block : latency_blocks_) {
+            for (size_t s = 0; s < StageCount; ++s) {
+                const LatencyBlock::Histogram& histogram = block->stages[s];
+                uint64_t* merged = &buckets[s * LatencyBuckets];
+                for (size_t i = 0; i < LatencyBuckets; ++i)
+                    merged[i] += histogram.buckets[i]
+                        .load(std::memory_order_relaxed);
+                counts[s] += histogram.count.load(std::memory_order_relaxed);
+                sums[s] += histogram.sum.load(std::memory_order_relaxed);
+            }
+        }
+        gauges = gauges_;
+    }
+
+    for (size_t i = 0; i < CounterCount; ++i) {
+        const CounterInfo& info = CounterInfos[i];
+        if (info.help != nullptr)
+            write_help_(out, info.name, info.help, "counter");
+        write_value_(out, info.name, info.label, totals[i]);
+    }
+
+    // a connection is counted closed by whichever thread closes it
+    size_t accepted = static_cast<size_t>(Counter::ConnectionsAccepted);
+    size_t closed = static_cast<size_t>(Counter::ConnectionsClosed);
+    uint64_t open = totals[accepted] > totals[closed]
+        ? totals[accepted] - totals[closed] : 0;
+    write_help_(out, "webstable_connections_open", "Connections open.",
+        "gauge");
+    write_value_(out, "webstable_connections_open", nullptr, open);
+
+    // quantiles are ranked within the buckets, a thread recording at the
+    // same time may have bumped one and not yet the others
+    write_help_(out, "webstable_stage_seconds",
+        "Time spent in each stage of a request.", "summary");
+    for (size_t s = 0; s < StageCount; ++s) {
+        const uint64_t* merged = &buckets[s * LatencyBuckets];
+        uint64_t count = 0;
+        for (size_t i = 0; i < LatencyBuckets; ++i)
+            count += merged[i];
+        char label[64];
+        for (double q : Quantiles) {
+            std::snprintf(label, sizeof(label),
+                "stage=\"%s\",quantile=\"%g\"", StageNames[s], q);
+            write_seconds_(out, "webstable_stage_seconds", label,
+                count ? quantile(merged, count, q) : 0);
+        }
+        std::snprintf(label, sizeof(label), "stage=\"%s\"", StageNames[s]);
+        write_seconds_(out, "webstable_stage_seconds_sum", label, sums[s]);
+        out += "webstable_stage_seconds_count{";
+        out += label;
+        out += "} ";
+        out += std::to_string(counts[s]);
+        out += '\n';
+    }
+
+    // read out of the lock, a gauge may take locks of its own
+    for (const Gauge& gauge : gauges) {
+        write_help_(out, gauge.name.c_str(), gauge.help.c_str(), "gauge");
+        write_value_(out, gauge.name.c_str(), nullptr, gauge.read());
+    }
+}
+
+} // namespace webstab
@@ -0,0 +1,194 @@
+// File:     src/core/Metrics.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_METRICS_H
+#define WEBSTABLE_CORE_METRICS_H
+
+// C
+#include <ctime>
+
+// C++
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace webstab {
+
+// counters of the whole process, exposed as Prometheus metrics
+enum class Counter : unsigned {
+    Requests,
+    BytesIn,
+    BytesOut,
+    Status1xx,
+    Status2xx,
+    Status3xx,
+    Status4xx,
+    Status5xx,
+    CacheHits,
+    CacheMisses,
+    CacheEvictions,
+    BufferReuses,
+    BufferAllocations,
+    AccessLogDrops,
+    ConnectionsAccepted,
+    ConnectionsClosed,
+    ConnectionsShed,
+};
+constexpr size_t CounterCount =
+    static_cast<size_t>(Counter::ConnectionsShed) + 1;
+
+// the counters of one thread, in cache lines of their own. only the
+// owning thread writes them, readers sum the blocks of every thread
+struct alignas(64) CounterBlock {
+    std::atomic<uint64_t> values[CounterCount];
+};
+
+// the stages of a request, each timed on its own:
+//   loop     the main loop handling one wakeup of the poller
+//   queue    a ready connection waiting for a worker thread
+//   parse    receiving and parsing one request
+//   respond  resolving the file and preparing the response head
+//   flush    sending the response
+enum class Stage : unsigned {
+    Loop,
+    Queue,
+    Parse,
+    Respond,
+    Flush,
+};
+constexpr size_t StageCount = static_cast<size_t>(Stage::Flush) + 1;
+
+// log-linear buckets in nanoseconds, 16 for each power of two, so that a
+// value is known within 1/16 of itself. longer times than 2^41 ns (about
+// 36 minutes) land in the last bucket
+constexpr unsigned LatencySubBits = 4;
+constexpr unsigned LatencyMaxBits = 41;
+constexpr size_t LatencyBuckets =
+    (LatencyMaxBits - LatencySubBits + 1) << LatencySubBits;
+
+// the histograms of one thread, written only by the owning thread
+struct alignas(64) LatencyBlock {
+    struct Histogram {
+        std::atomic<uint64_t> buckets[LatencyBuckets];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+    };
+    Histogram stages[StageCount];
+};
+
+class Metrics final {
+    // attached on the first count of each thread, kept after it exits
+    static inline thread_local CounterBlock* local_ = nullptr;
+    static inline thread_local LatencyBlock* latency_ = nullptr;
+
+    static CounterBlock* attach_();
+    static LatencyBlock* attach_latency_();
+
+    static inline void bump_(std::atomic<uint64_t>& value,
+            uint64_t n) noexcept {
+        value.store(value.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed);
+    }
+
+public:
+    // a value read when the metrics are exposed
+    using gauge_t = std::function<uint64_t()>;
+
+    Metrics() = delete;
+
+    // a plain load and store on the counters of the calling thread, no
+    // locked instruction on the request path
+    static inline void add(Counter counter, uint64_t n = 1) noexcept {
+        CounterBlock* block = local_;
+        if (block == nullptr) block = local_ = attach_();
+        bump_(block->values[static_cast<size_t>(counter)], n);
+    }
+
+    // monotonic nanoseconds, read from the vDSO without a system call
+    static inline uint64_t now() noexcept {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000UL
+            + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // the bucket of 'ns': the value itself below 16, otherwise its top
+    // five bits and the position of the highest one
+    static inline size_t bucket(uint64_t ns) noexcept {
+        constexpr uint64_t max = (1UL << LatencyMaxBits) - 1;
+        if (ns > max) ns = max;
+        if (ns < (1UL << LatencySubBits)) return static_cast<size_t>(ns);
+        unsigned shift = 63 - static_cast<unsigned>(__builtin_clzll(ns))
+            - LatencySubBits;
+        return (static_cast<size_t>(shift + 1) << LatencySubBits)
+            + static_cast<size_t>((ns >> shift)
+                & ((1UL << LatencySubBits) - 1));
+    }
+
+    // the largest value counted in 'bucket'
+    static inline uint64_t bucket_max(size_t bucket) noexcept {
+        constexpr size_t sub_count = 1UL << LatencySubBits;
+        if (bucket < sub_count) return bucket;
+        unsigned shift = static_cast<unsigned>(bucket >> LatencySubBits) - 1;
+        uint64_t top = sub_count + (bucket & (sub_count - 1));
+        return ((top + 1) << shift) - 1;
+    }
+
+    // the smallest bucket bound under which a fraction 'q' of the 'count'
+    // values in 'buckets' fall
+    static uint64_t quantile(const uint64_t* buckets, uint64_t count,
+        double q) noexcept;
+
+    // the time of 'stage' from 'start' to 'end', from now()
+    static inline void record(Stage stage, uint64_t start,
+            uint64_t end) noexcept {
+        LatencyBlock* block = latency_;
+        if (block == nullptr) block = latency_ = attach_latency_();
+        uint64_t ns = end > start ? end - start : 0;
+        LatencyBlock::Histogram& histogram =
+            block->stages[static_cast<size_t>(stage)];
+        bump_(histogram.buckets[bucket(ns)], 1);
+        bump_(histogram.count, 1);
+        bump_(histogram.sum, ns);
+    }
+
+    // counts a response by the class of its status code
+    static void add_status(int status) noexcept;
+
+    static void add_gauge(std::string name, std::string help, gauge_t read);
+    static void clear_gauges() noexcept;
+
+    // every counter and gauge, and p50/p99/p999 of every stage since
+    // the start, in the Prometheus text format
+    static void expose(std::string& out);
+
+}; // class Metrics
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_METRICS_H
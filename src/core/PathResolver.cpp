@@ -0,0 +1,118 @@
+// File:     src/core/PathResolver.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PathResolver.h"
+
+// C++
+#include <functional>
+#include <vector>
+
+// Linux
+#include <sys/stat.h>
+
+// WebStable
+#include "http/PathNormalizer.h"
+
+namespace webstab {
+
+namespace {
+
+// slots of the direct-mapped table of each thread
+constexpr size_t ResolveSlots = 1024;
+
+// longer targets are resolved every time instead of being kept
+constexpr size_t MaxMemoTarget = 512;
+
+struct Slot {
+    uint64_t generation = 0;
+    std::string target;
+    ResolvedPath resolved;
+};
+
+Slot& slot_(std::string_view target) {
+    thread_local std::vector<Slot> slots(ResolveSlots);
+    return slots[std::hash<std::string_view>()(target) % ResolveSlots];
+}
+
+// 'html' of '/www/index.html', nothing for '/www/.profile'
+std::string_view extension_(std::string_view filepath) {
+    std::string_view filename = filepath.substr(filepath.rfind('/') + 1);
+    size_t dot = filename.rfind('.');
+    if (dot == 0 || dot == std::string_view::npos)
+        return std::string_view();
+    return filename.substr(dot + 1);
+}
+
+bool resolve_(const RuntimeConfig& cfg, std::string_view target,
+        ResolvedPath& resolved, int& status) {
+    thread_local std::string path;
+    if (!normalize_path(target, path)) {
+        status = 400;
+        return false;
+    }
+    std::string_view rest;
+    resolved.mount = cfg.route(path, rest);
+    if (resolved.mount == nullptr) {
+        status = 404;
+        return false;
+    }
+    std::string& filepath = resolved.filepath;
+    filepath.assign(resolved.mount->dir).append(rest);
+    struct stat st {};
+    if (::stat(filepath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        if (filepath.back() != '/') filepath.push_back('/');
+        filepath.append(resolved.mount->index);
+    }
+    resolved.mime = &cfg.type(extension_(filepath));
+    return true;
+}
+
+} // anonymous namespace
+
+const ResolvedPath* resolve_path(const RuntimeConfig& cfg,
+        std::string_view target, int& status) {
+    Slot& slot = slot_(target);
+    if (slot.generation == cfg.generation() && slot.target == target)
+        return &slot.resolved;
+
+    // the slot is reused, its strings keep their capacity
+    slot.generation = 0;
+    if (!resolve_(cfg, target, slot.resolved, status))
+        return nullptr;
+    if (target.size() <= MaxMemoTarget) {
+        slot.target.assign(target);
+        slot.generation = cfg.generation();
+    }
+    return &slot.resolved;
+}
+
+void forget_path(const RuntimeConfig& cfg, std::string_view target) noexcept {
+    Slot& slot = slot_(target);
+    if (slot.generation == cfg.generation() && slot.target == target)
+        slot.generation = 0;
+}
+
+} // namespace webstab
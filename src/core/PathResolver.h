@@ -0,0 +1,61 @@
+// File:     src/core/PathResolver.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_PATHRESOLVER_H
+#define WEBSTABLE_CORE_PATHRESOLVER_H
+
+// C++
+#include <string>
+#include <string_view>
+
+// WebStable
+#include "app/RuntimeConfig.h"
+
+namespace webstab {
+
+// a request target resolved to the file that serves it
+struct ResolvedPath {
+    const Mount* mount = nullptr;
+    const MimeType* mime = nullptr;
+    std::string filepath;
+};
+
+// normalises 'target', routes it to its mount and applies the index of
+// directories. results are memoised per thread in a bounded table keyed
+// by the raw target, for the snapshot 'cfg' only. the result stays valid
+// until the next call on the same thread. nullptr with 'status' set to
+// 400 or 404 when the target cannot be served
+const ResolvedPath* resolve_path(const RuntimeConfig& cfg,
+    std::string_view target, int& status);
+
+// drops the memoised result of 'target', when its file turned out to be
+// missing
+void forget_path(const RuntimeConfig& cfg, std::string_view target) noexcept;
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_PATHRESOLVER_H
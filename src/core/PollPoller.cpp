@@ -0,0 +1,108 @@
+// File:     src/core/PollPoller.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PollPoller.h"
+
+// C
+#include <cerrno>
+#include <cstring>
+
+// C++
+#include <string>
+
+namespace webstab {
+
+void PollPoller::insert(int fd, int events) {
+    if (fd < 0)
+        throw iohub::IOHubExcept("[PollPoller] insert(): bad fd");
+    size_t slot = static_cast<size_t>(fd);
+    if (slot >= index_.size()) index_.resize(slot + 1, Absent);
+    if (index_[slot] != Absent)
+        throw iohub::IOHubExcept("[PollPoller] insert(): fd "
+            + std::to_string(fd) + " is already watched");
+    index_[slot] = pollfds_.size();
+    pollfds_.push_back({ fd, static_cast<short>(events), 0 });
+}
+
+void PollPoller::erase(int fd) {
+    size_t slot = static_cast<size_t>(fd);
+    if (fd < 0 || slot >= index_.size() || index_[slot] == Absent)
+        throw iohub::IOHubExcept("[PollPoller] erase(): fd "
+            + std::to_string(fd) + " is not watched");
+    // the last one fills the hole, its index moves with it
+    size_t hole = index_[slot];
+    pollfds_[hole] = pollfds_.back();
+    index_[static_cast<size_t>(pollfds_[hole].fd)] = hole;
+    pollfds_.pop_back();
+    index_[slot] = Absent;
+}
+
+void PollPoller::modify(int fd, int events) {
+    size_t slot = static_cast<size_t>(fd);
+    if (fd < 0 || slot >= index_.size() || index_[slot] == Absent)
+        throw iohub::IOHubExcept("[PollPoller] modify(): fd "
+            + std::to_string(fd) + " is not watched");
+    pollfds_[index_[slot]].events = static_cast<short>(events);
+}
+
+size_t PollPoller::size() const noexcept {
+    return pollfds_.size();
+}
+
+void PollPoller::clear() noexcept {
+    index_.clear();
+    pollfds_.clear();
+}
+
+size_t PollPoller::wait(std::vector<iohub::fd_event_t>& fdevt_arr,
+        int timeout) {
+    fdevt_arr.clear();
+    int ready = ::poll(pollfds_.data(), pollfds_.size(), timeout);
+    if (ready == -1) {
+        int err = errno;
+        iohub::IOHubExcept except(std::string("[PollPoller] wait(): ")
+            + std::strerror(err));
+        errno = err;
+        throw except;
+    }
+    for (const pollfd& pfd : pollfds_) {
+        if (ready == 0) break;
+        if (pfd.revents == 0) continue;
+        fdevt_arr.emplace_back(pfd.fd, pfd.revents);
+        --ready;
+    }
+    return fdevt_arr.size();
+}
+
+bool PollPoller::is_open() const noexcept {
+    return true;
+}
+
+void PollPoller::close() noexcept {
+    clear();
+}
+
+} // namespace webstab
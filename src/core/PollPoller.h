@@ -0,0 +1,75 @@
+// File:     src/core/PollPoller.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_POLLPOLLER_H
+#define WEBSTABLE_CORE_POLLPOLLER_H
+
+// C++
+#include <vector>
+
+// Linux
+#include <poll.h>
+
+// WebStable
+#include "iohub.h"
+
+namespace webstab {
+
+// the 'poll' poller. iohub::Poll does not move the index of the last
+// descriptor when it fills the slot of an erased one, so after some
+// erases it reports descriptors it no longer has and loses others
+class PollPoller : public iohub::PollerBase {
+    // index into 'pollfds_' by descriptor, Absent when not watched
+    static constexpr size_t Absent = static_cast<size_t>(-1);
+    std::vector<size_t> index_;
+    std::vector<pollfd> pollfds_;
+
+public:
+    PollPoller() = default;
+    virtual ~PollPoller() override = default;
+
+    // throw iohub::IOHubExcept when 'fd' is already watched, or not
+    virtual void insert(int fd, int events) override;
+    virtual void erase(int fd) override;
+    virtual void modify(int fd, int events) override;
+
+    virtual size_t size() const noexcept override;
+    virtual void clear() noexcept override;
+
+    // the ready descriptors and their events into 'fdevt_arr', throws
+    // iohub::IOHubExcept with errno kept when poll() fails
+    virtual size_t wait(std::vector<iohub::fd_event_t>& fdevt_arr,
+        int timeout = -1) override;
+
+    virtual bool is_open() const noexcept override;
+    virtual void close() noexcept override;
+
+}; // class PollPoller
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_POLLPOLLER_H
@@ -0,0 +1,57 @@
+// File:     src/core/RequestArena.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RequestArena.h"
+
+// C++
+#include <memory>
+
+namespace webstab {
+
+namespace {
+
+// the block is allocated on the first use, threads that never reply to
+// a request do not hold one
+struct ThreadArena {
+    std::unique_ptr<char[]> block { new char[ArenaBlockSize] };
+    std::pmr::monotonic_buffer_resource resource { block.get(),
+        ArenaBlockSize, std::pmr::new_delete_resource() };
+};
+
+thread_local std::unique_ptr<ThreadArena> arena_;
+
+} // anonymous namespace
+
+std::pmr::memory_resource* RequestArena::resource() {
+    if (!arena_) arena_ = std::make_unique<ThreadArena>();
+    return &arena_->resource;
+}
+
+void RequestArena::reset() noexcept {
+    if (arena_) arena_->resource.release();
+}
+
+} // namespace webstab
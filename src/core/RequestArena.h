@@ -0,0 +1,58 @@
+// File:     src/core/RequestArena.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_CORE_REQUESTARENA_H
+#define WEBSTABLE_CORE_REQUESTARENA_H
+
+// C++
+#include <cstddef>
+#include <memory_resource>
+
+namespace webstab {
+
+// bytes of the block each thread keeps for its requests
+constexpr size_t ArenaBlockSize = 16 * 1024;
+
+// scratch memory of the request a thread is replying to. strings built
+// for a response are carved from the block of the thread and all dropped
+// at once when the request ends, what does not fit comes from new
+class RequestArena final {
+public:
+    RequestArena() = delete;
+
+    // the memory resource of this thread
+    static std::pmr::memory_resource* resource();
+
+    // drops everything allocated since the last reset, memory taken
+    // beyond the block is freed
+    static void reset() noexcept;
+
+}; // class RequestArena
+
+} // namespace webstab
+
+#endif // WEBSTABLE_CORE_REQUESTARENA_H
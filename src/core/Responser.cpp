@@ -26,111 +26,601 @@
 
 #include "Responser.h"
 
+// C
+#include <cerrno>
+#include <cstdio>
+
+// C++
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+
+// Linux
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 // WebStable
 #include "app/version.h"
-
-#include <cstring>
+#include "core/AccessLog.h"
+#include "core/Metrics.h"
+#include "core/PathResolver.h"
+#include "core/RequestArena.h"
+#include "http/Gzip.h"
+#include "http/HttpDate.h"
+#include "http/HttpParser.h"
 
 namespace webstab {
 
 namespace {
 
-constexpr char DEFAULT_404_PAGE[] =
-    "<html>"
-        "<head>"
-            "<title>404 Not Found</title>"
-        "</head>"
-        "<body>"
-            "<center><h1>404 Not Found</h1></center>"
-            "<hr>"
-            "<center>WebStable/" TOSTRING(WEBSTABLE_VERSION) "</center>"
-        "</body>"
-    "</html>\n";
+// the heads of the responses are written on the stack. the configured
+// values in them are limited by Config::MaxFieldValueLength, so that a
+// head with all of them still fits
+constexpr size_t MaxHeadLength = 2048;
+
+// ends the head in 'writer', one that does not fit is reported and the
+// connection is closed without an answer
+size_t finish_(ResponseWriter& writer, std::string_view path) {
+    size_t length = writer.finish();
+    if (!length) {
+        std::cerr << "Response head for " << path << " is larger than "
+            << MaxHeadLength << " bytes" << std::endl;
+    }
+    return length;
+}
+
+// 'bytes 0-499/1234'
+constexpr size_t ContentRangeLength = 64;
+
+std::string_view content_range_(char (&buf)[ContentRangeLength],
+        const ByteRange& range, size_t size) {
+    int len = std::snprintf(buf, sizeof(buf), "bytes %zu-%zu/%zu",
+        range.first, range.last, size);
+    return std::string_view(buf, static_cast<size_t>(len));
+}
+
+// separates the parts of multipart/byteranges, chosen once per process
+const std::string& boundary_() {
+    static const std::string boundary = [] {
+        std::random_device random;
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%08x%08x", random(), random());
+        return std::string("WebStable-") + buf;
+    }();
+    return boundary;
+}
+
+// 'If-None-Match: "a", W/"b"' matches 'etag' with weak comparison
+bool etag_matches_(std::string_view list, std::string_view etag) {
+    if (etag.substr(0, 2) == "W/") etag.remove_prefix(2);
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view tag = list.substr(0, comma);
+        while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+            tag.remove_prefix(1);
+        while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+            tag.remove_suffix(1);
+        if (tag == "*") return true;
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        if (tag == etag) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+// input read from the file for each chunk of a compressed stream
+constexpr size_t GzipStreamInput = 64UL * 1024UL;
+
+// responses being compressed on the fly, bounded by 'gzip_stream_limit'
+// so that compression cannot take every core
+std::atomic<size_t> gzip_streams_ { 0 };
+
+bool acquire_gzip_stream_(size_t limit) {
+    size_t streams = gzip_streams_.load(std::memory_order_relaxed);
+    do {
+        if (streams >= limit) return false;
+    } while (!gzip_streams_.compare_exchange_weak(streams, streams + 1,
+        std::memory_order_relaxed));
+    return true;
+}
+
+void release_gzip_stream_() {
+    gzip_streams_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool read_at_(int fd, char* buf, size_t len, size_t offset) {
+    while (len) {
+        ssize_t ret = ::pread(fd, buf, len, static_cast<off_t>(offset));
+        if (ret == -1 && errno == EINTR) continue;
+        // the file was truncated under us
+        if (ret <= 0) return false;
+        buf += ret;
+        len -= static_cast<size_t>(ret);
+        offset += static_cast<size_t>(ret);
+    }
+    return true;
+}
 
-constexpr size_t DEFAULT_404_PAGE_LENGTH = sizeof(DEFAULT_404_PAGE) - 1;
+// <html>
+//   <head><title>404 Not Found</title></head>
+//   <body>
+//     <center><h1>404 Not Found</h1></center>
+//     <hr>
+//     <center>WebStable/1.0</center>
+//   </body>
+// </html>
+void default_page_(std::pmr::string& page, std::string_view status) {
+    page.append("<html>"
+            "<head>"
+                "<title>").append(status).append("</title>"
+            "</head>"
+            "<body>"
+                "<center><h1>").append(status).append("</h1></center>"
+                "<hr>"
+                "<center>WebStable/" TOSTRING(WEBSTABLE_VERSION) "</center>"
+            "</body>"
+        "</html>\n");
+}
 
 } // anonymous namespace
 
-bool Responser::send_default_404_page_() {
-    HttpResponse respond;
-    respond.status_code = "404";
-    respond.status_message = "Not Found";
-    respond.headers["Server"] = cfg_.server_name();
-    respond.headers["Content-Type"] = "text/html";
-    respond.headers["Content-Length"] = std::to_string(DEFAULT_404_PAGE_LENGTH);
-    std::string str = respond.to_string();
-    try {
-        nano::send_msg(sock_, str.c_str(), str.size(), MSG_NOSIGNAL);
-        nano::send_msg(sock_, DEFAULT_404_PAGE, DEFAULT_404_PAGE_LENGTH, MSG_NOSIGNAL);
-    } catch (const nano::NanoExcept& e) {
-        return false;
+bool Responser::wait_writable_() {
+    pollfd pfd{ sock_, POLLOUT, 0 };
+    int ret;
+    do {
+        ret = ::poll(&pfd, 1, cfg_.keepalive_ms());
+    } while (ret == -1 && errno == EINTR);
+    return ret > 0;
+}
+
+bool Responser::send_iov_(iovec* iov, size_t count, int flags) {
+    msghdr msg {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    if (first_send_ == 0) first_send_ = Metrics::now();
+    while (msg.msg_iovlen) {
+        ssize_t ret = ::sendmsg(sock_, &msg, MSG_NOSIGNAL | flags);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && wait_writable_()) continue;
+            return false;
+        }
+        // skip what was sent
+        size_t sent = static_cast<size_t>(ret);
+        Metrics::add(Counter::BytesOut, sent);
+        sent_ += sent;
+        while (msg.msg_iovlen && sent >= msg.msg_iov->iov_len) {
+            sent -= msg.msg_iov->iov_len;
+            ++msg.msg_iov;
+            --msg.msg_iovlen;
+        }
+        if (msg.msg_iovlen) {
+            msg.msg_iov->iov_base = static_cast<char*>(
+                msg.msg_iov->iov_base) + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
     }
     return true;
 }
 
-bool Responser::send_respond_(const std::filesystem::path& path,
-        const std::string& body) {
-    std::string extension = path.extension().string();
-    if (!extension.empty() && extension.front() == '.')
-        extension = extension.substr(1);
-    std::string type = cfg_.type(extension);
-    HttpResponse respond;
-    respond.version = request_.version;
-    respond.headers["Server"] = cfg_.server_name();
-    respond.headers["Content-Type"] = type;
-    respond.headers["Content-Length"] = std::to_string(body.size());
-    std::string str = respond.to_string();
-    try {
-        do {
-            try {
-                nano::send_msg(sock_, str.c_str(), str.size(), MSG_NOSIGNAL);
-            } catch (const nano::NanoExcept& e) {
-                if (errno == EWOULDBLOCK) {
-                    continue;
-                } else {
-                    return false;
-                }
-            }
-        } while (false);
-        size_t last = body.size();
-        const size_t SingleSendLength = 8192U;
-        for (const char* p = body.c_str(); last;) {
-            size_t send_len = std::min(last, SingleSendLength);
-            size_t ret = -1;
-            while (true) {
-                try {
-                    ret = nano::send_msg(sock_, p, send_len);
-                } catch (const std::exception& e) {
-                    if (errno == EAGAIN)
-                        continue;
-                    else
-                        return false;
-                }
-                break;
-            }
-            p += ret;
-            last -= ret;
+bool Responser::send_all_(const char* head, size_t head_length,
+        const char* body, size_t body_length) {
+    // the body of a HEAD request is left out, the head still gives the
+    // Content-Length of the GET
+    if (head_only_) body_length = 0;
+    // head and body leave in one system call when the socket has room
+    iovec iov[2] = {
+        { const_cast<char*>(head), head_length },
+        { const_cast<char*>(body), body_length },
+    };
+    return send_iov_(iov, 2, 0);
+}
+
+bool Responser::send_file_(int fd, size_t offset, size_t length) {
+    off_t off = static_cast<off_t>(offset);
+    if (first_send_ == 0) first_send_ = Metrics::now();
+    while (length) {
+        ssize_t ret = ::sendfile(sock_, fd, &off, length);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && wait_writable_()) continue;
+            return false;
         }
-    } catch (...) {
-        return false;
+        // the file was truncated under us
+        if (ret == 0) return false;
+        length -= static_cast<size_t>(ret);
+        Metrics::add(Counter::BytesOut, static_cast<uint64_t>(ret));
+        sent_ += static_cast<size_t>(ret);
     }
     return true;
 }
 
-Responser::Responser(const Config& cfg,
+bool Responser::send_body_(const FileCache::Body& body,
+        const char* head, size_t head_length, size_t offset, size_t length) {
+    // a slice of the cached bytes, or straight from the page cache
+    if (body.cached() || head_only_)
+        return send_all_(head, head_length,
+            body.content.data() + offset, length);
+    iovec iov { const_cast<char*>(head), head_length };
+    return send_iov_(&iov, 1, MSG_MORE)
+        && send_file_(body.fd, offset, length);
+}
+
+void Responser::write_head_(ResponseWriter& writer, int status) {
+    Metrics::add_status(status);
+    status_ = status;
+    writer.status(status);
+    writer.date();
+    writer.header("Server", cfg_.server_name());
+}
+
+void Responser::write_validators_(ResponseWriter& writer,
+        const FileCache::Entry& entry, std::string_view etag) const {
+    writer.header("Last-Modified", entry.last_modified);
+    writer.header("ETag", etag);
+    if (vary_)
+        writer.header("Vary", "Accept-Encoding");
+    if (!mount_->cache_control.empty())
+        writer.header("Cache-Control", mount_->cache_control);
+}
+
+bool Responser::send_error_page_(int status, bool keep_alive) {
+    char code[12];
+    std::snprintf(code, sizeof(code), "%d", status);
+    std::pmr::string title(RequestArena::resource()), page(
+        RequestArena::resource());
+    title.append(code).append(1, ' ').append(status_reason(status));
+    default_page_(page, title);
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, status);
+    writer.header("Content-Type", "text/html");
+    writer.header("Content-Length", page.size());
+    if (!keep_alive)
+        writer.header("Connection", "close");
+    size_t head_length = finish_(writer, request_.path);
+    return head_length
+        && send_all_(head, head_length, page.data(), page.size());
+}
+
+bool Responser::send_respond_(const FileCache::Entry& entry,
+        const FileCache::Body& body) {
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 200);
+    writer.header("Content-Type", mime_->type);
+    if (&body == &entry.gzip)
+        writer.header("Content-Encoding", "gzip");
+    writer.header("Content-Length", body.size);
+    write_validators_(writer, entry, body.etag);
+    writer.header("Accept-Ranges", "bytes");
+    size_t head_length = finish_(writer, request_.path);
+    return head_length && send_body_(body, head, head_length, 0, body.size);
+}
+
+bool Responser::send_partial_(const FileCache::Entry& entry,
+        const FileCache::Body& body, const ByteRange& range) {
+    char content_range[ContentRangeLength];
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 206);
+    writer.header("Content-Type", mime_->type);
+    if (&body == &entry.gzip)
+        writer.header("Content-Encoding", "gzip");
+    writer.header("Content-Length", range.length());
+    writer.header("Content-Range",
+        content_range_(content_range, range, body.size));
+    write_validators_(writer, entry, body.etag);
+    writer.header("Accept-Ranges", "bytes");
+    size_t head_length = finish_(writer, request_.path);
+    return head_length && send_body_(body, head, head_length,
+        range.first, range.length());
+}
+
+bool Responser::send_multipart_(const FileCache::Entry& entry,
+        const FileCache::Body& body, const RangeSet& set) {
+    // every part is its own head followed by a slice of the file
+    const std::string& boundary = boundary_();
+    const std::string& type = mime_->type;
+    std::pmr::string parts(RequestArena::resource());
+    size_t part_end[MaxRanges];
+    size_t length = 0;
+    char content_range[ContentRangeLength];
+    for (size_t i = 0; i < set.count; ++i) {
+        const ByteRange& range = set.ranges[i];
+        parts.append("\r\n--").append(boundary)
+            .append("\r\nContent-Type: ").append(type)
+            .append("\r\nContent-Range: ")
+            .append(content_range_(content_range, range, body.size))
+            .append("\r\n\r\n");
+        part_end[i] = parts.size();
+        length += range.length();
+    }
+    std::pmr::string closing(RequestArena::resource());
+    closing.append("\r\n--").append(boundary).append("--\r\n");
+    length += parts.size() + closing.size();
+    std::pmr::string content_type(RequestArena::resource());
+    content_type.append("multipart/byteranges; boundary=").append(boundary);
+
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 206);
+    writer.header("Content-Type", content_type);
+    if (&body == &entry.gzip)
+        writer.header("Content-Encoding", "gzip");
+    writer.header("Content-Length", length);
+    write_validators_(writer, entry, body.etag);
+    writer.header("Accept-Ranges", "bytes");
+    size_t head_length = finish_(writer, request_.path);
+    if (!head_length) return false;
+    if (head_only_) return send_all_(head, head_length, nullptr, 0);
+
+    if (body.cached()) {
+        iovec iov[2 * MaxRanges + 2];
+        size_t count = 0;
+        iov[count++] = { head, head_length };
+        for (size_t i = 0, part_begin = 0; i < set.count; ++i) {
+            const ByteRange& range = set.ranges[i];
+            iov[count++] = { &parts[part_begin], part_end[i] - part_begin };
+            iov[count++] = { const_cast<char*>(body.content.data())
+                + range.first, range.length() };
+            part_begin = part_end[i];
+        }
+        iov[count++] = { &closing[0], closing.size() };
+        return send_iov_(iov, count, 0);
+    }
+
+    iovec iov[2] = { { head, head_length } };
+    for (size_t i = 0, part_begin = 0; i < set.count; ++i) {
+        const ByteRange& range = set.ranges[i];
+        // the head of the response goes out with the first part
+        iov[1] = { &parts[part_begin], part_end[i] - part_begin };
+        if (!send_iov_(i == 0 ? iov : iov + 1, i == 0 ? 2 : 1, MSG_MORE)
+            || !send_file_(body.fd, range.first, range.length()))
+            return false;
+        part_begin = part_end[i];
+    }
+    return send_all_(closing.data(), closing.size(), nullptr, 0);
+}
+
+bool Responser::send_gzip_stream_(const FileCache::Entry& entry,
+        std::string_view etag) {
+    // one compressor and its buffers per thread, reused by every response
+    thread_local GzipStream stream;
+    thread_local std::string input, output;
+    if (!head_only_ && !stream.reset(cfg_.gzip_stream_level()))
+        return false;
+
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 200);
+    writer.header("Content-Type", mime_->type);
+    writer.header("Content-Encoding", "gzip");
+    writer.header("Transfer-Encoding", "chunked");
+    write_validators_(writer, entry, etag);
+    size_t head_length = finish_(writer, request_.path);
+    if (head_only_)
+        return head_length && send_all_(head, head_length, nullptr, 0);
+    iovec head_iov { head, head_length };
+    if (!head_length || !send_iov_(&head_iov, 1, MSG_MORE))
+        return false;
+
+    // every piece of output is sent as a chunk as soon as deflate has it
+    const FileCache::Body& body = entry.identity;
+    input.resize(GzipStreamInput);
+    for (size_t offset = 0; ; ) {
+        size_t len = std::min(GzipStreamInput, body.size - offset);
+        if (!read_at_(body.fd, &input[0], len, offset))
+            return false;
+        offset += len;
+        bool finish = offset == body.size;
+        output.clear();
+        if (!stream.write(input.data(), len, finish, output))
+            return false;
+
+        char chunk_size[20];
+        int chunk_size_length = std::snprintf(chunk_size,
+            sizeof(chunk_size), "%zx\r\n", output.size());
+        iovec iov[4];
+        size_t count = 0;
+        if (!output.empty()) {
+            iov[count++] = { chunk_size,
+                static_cast<size_t>(chunk_size_length) };
+            iov[count++] = { &output[0], output.size() };
+            iov[count++] = { const_cast<char*>("\r\n"), 2 };
+        }
+        if (finish)
+            iov[count++] = { const_cast<char*>("0\r\n\r\n"), 5 };
+        if (count && !send_iov_(iov, count, finish ? 0 : MSG_MORE))
+            return false;
+        if (finish) return true;
+    }
+}
+
+bool Responser::send_range_not_satisfiable_(const FileCache::Body& body) {
+    char content_range[ContentRangeLength];
+    std::snprintf(content_range, sizeof(content_range),
+        "bytes */%zu", body.size);
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 416);
+    writer.header("Content-Length", size_t(0));
+    writer.header("Content-Range", content_range);
+    size_t head_length = finish_(writer, request_.path);
+    return head_length && send_all_(head, head_length, nullptr, 0);
+}
+
+bool Responser::send_not_modified_(const FileCache::Entry& entry,
+        std::string_view etag) {
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 304);
+    write_validators_(writer, entry, etag);
+    size_t head_length = finish_(writer, request_.path);
+    return head_length && send_all_(head, head_length, nullptr, 0);
+}
+
+bool Responser::not_modified_(const FileCache::Entry& entry,
+        std::string_view etag) const {
+    if (request_.method != "GET" && request_.method != "HEAD")
+        return false;
+
+    // If-None-Match takes precedence, If-Modified-Since is only
+    // evaluated without it (RFC 9110, 13.2.2)
+    std::string_view if_none_match = request_.header(HeaderIfNoneMatch);
+    if (if_none_match.data() != nullptr)
+        return etag_matches_(if_none_match, etag);
+
+    std::string_view if_modified_since =
+        request_.header(HeaderIfModifiedSince);
+    if (if_modified_since.empty())
+        return false;
+    if (if_modified_since == entry.last_modified)
+        return true;
+    std::time_t since = parse_http_date(if_modified_since);
+    return since != -1 && entry.mtime <= since;
+}
+
+RangeResult Responser::range_of_(const FileCache::Entry& entry,
+        const FileCache::Body& body, RangeSet& set) const {
+    std::string_view range = request_.header(HeaderRange);
+    if (range.empty() || request_.method != "GET")
+        return RangeResult::Ignore;
+
+    // If-Range uses the strong comparison, a range of a representation
+    // that changed is sent as a whole
+    std::string_view if_range = request_.header(HeaderIfRange);
+    if (!if_range.empty()) {
+        bool matched = if_range.front() == '"'
+            ? if_range == body.etag
+            : if_range == entry.last_modified;
+        if (!matched) return RangeResult::Ignore;
+    }
+    return parse_range(range, body.size, set);
+}
+
+Responser::Responser(const RuntimeConfig& cfg, FileCache& cache,
         const HttpRequest& request, const nano::sock_t& sock)
-    : cfg_(cfg), request_(request), sock_(sock) {}
+    : cfg_(cfg), cache_(cache), request_(request), sock_(sock),
+    head_only_(request.method == "HEAD") {}
+
+Responser::~Responser() {
+    RequestArena::reset();
+}
+
+bool Responser::reply_gzip_stream_(const FileCache::Entry& entry) {
+    // the output depends on the level and zlib, so the validator is weak
+    std::pmr::string etag(RequestArena::resource());
+    etag.append("W/").append(entry.identity.etag);
+    etag.insert(etag.size() - 1, "-gz");
+    if (not_modified_(entry, etag))
+        return send_not_modified_(entry, etag);
+    return send_gzip_stream_(entry, etag);
+}
+
+bool Responser::reply_status_() {
+    std::string text;
+    Metrics::expose(text);
+    char head[MaxHeadLength];
+    ResponseWriter writer(head, sizeof(head));
+    write_head_(writer, 200);
+    writer.header("Content-Type", "text/plain; version=0.0.4");
+    writer.header("Content-Length", text.size());
+    writer.header("Cache-Control", "no-store");
+    size_t head_length = finish_(writer, request_.path);
+    return head_length
+        && send_all_(head, head_length, text.data(), text.size());
+}
 
 bool Responser::reply() {
-    auto path = cfg_.static_path("root").append(request_.relative_path());
-    if (std::filesystem::is_directory(path))
-        path.append(cfg_.server("index"));
-    std::string file_content;
-    bool send_success = cache_.get_file(path.string(), file_content)
-        ? send_respond_(path, file_content) // get file success
-        : send_default_404_page_();         // get file failed
+    // the metrics endpoint takes precedence over the files, for the
+    // peers it is allowed to
+    const std::string& status_path = cfg_.status_path();
+    std::string_view path = request_.path.substr(0, request_.path.find('?'));
+    if (!status_path.empty() && path == status_path) {
+        char peer[PeerNameLength];
+        AccessLog::peer_name(sock_, peer);
+        if (cfg_.status_allowed(peer))
+            return reply_status_() && request_.keep_alive();
+    }
+
+    int status = 0;
+    const ResolvedPath* resolved = resolve_path(cfg_, request_.path, status);
+    FileCache::EntryPtr entry;
+    if (resolved != nullptr) {
+        entry = cache_.get_file(resolved->filepath,
+            resolved->mount->cache_policy, resolved->mime->compressible);
+        if (!entry) {
+            // the memoised result may be outdated, resolve it once more
+            forget_path(cfg_, request_.path);
+            resolved = resolve_path(cfg_, request_.path, status);
+            if (resolved != nullptr)
+                entry = cache_.get_file(resolved->filepath,
+                    resolved->mount->cache_policy,
+                    resolved->mime->compressible);
+        }
+        if (!entry) {
+            forget_path(cfg_, request_.path);
+            status = 404;
+        }
+    }
+    if (!entry)
+        return send_error_page_(status, true) && request_.keep_alive();
+    mount_ = resolved->mount;
+    mime_ = resolved->mime;
+    bool compressible = mime_->compressible;
+
+    // files too large for the cache and without a precompressed variant
+    // are compressed on the fly, in chunks, within the CPU budget
+    bool gzip = accepts_encoding(
+        request_.header(HeaderAcceptEncoding), "gzip");
+    bool streamable = compressible && !entry->has_gzip()
+        && !entry->cached() && cfg_.gzip_stream_level() > 0;
+    vary_ = entry->has_gzip() || streamable;
+    if (streamable && gzip
+            && (request_.method == "GET" || head_only_)
+            && request_.version == "HTTP/1.1"
+            && request_.header(HeaderRange).empty()
+            && acquire_gzip_stream_(cfg_.gzip_stream_limit())) {
+        bool send_success = reply_gzip_stream_(*entry);
+        release_gzip_stream_();
+        return send_success && request_.keep_alive();
+    }
+
+    // the gzip variant when the client takes it
+    const FileCache::Body& body = gzip && entry->has_gzip()
+        ? entry->gzip : entry->identity;
+
+    bool send_success = false;
+    RangeSet ranges;
+    if (not_modified_(*entry, body.etag)) {
+        send_success = send_not_modified_(*entry, body.etag);
+    } else switch (range_of_(*entry, body, ranges)) {
+    case RangeResult::Satisfiable:
+        send_success = ranges.count == 1
+            ? send_partial_(*entry, body, ranges.ranges[0])
+            : send_multipart_(*entry, body, ranges);
+        break;
+    case RangeResult::NotSatisfiable:
+        send_success = send_range_not_satisfiable_(body);
+        break;
+    default:
+        send_success = send_respond_(*entry, body);
+        break;
+    }
     return send_success && request_.keep_alive();
 }
 
-} // namespace webstab
+bool Responser::reply_error(int status) {
+    send_error_page_(status, false);
+    return false;
+}
 
+} // namespace webstab
@@ -28,33 +28,95 @@
 #ifndef WEBSTABLE_CORE_RESPONSER_H
 #define WEBSTABLE_CORE_RESPONSER_H
 
+// Linux
+#include <sys/uio.h>
+
 // nanonet
 #include "nanonet.h"
 
 // WebStable
-#include "app/Config.h"
+#include "app/RuntimeConfig.h"
+#include "http/ByteRange.h"
 #include "http/HttpRequest.h"
-#include "http/HttpResponse.h"
+#include "http/ResponseWriter.h"
 #include "file/FileCache.h"
 
 namespace webstab {
 
 class Responser {
-    const Config& cfg_;
+    const RuntimeConfig& cfg_;
+    FileCache& cache_;
     const HttpRequest& request_;
     const nano::sock_t& sock_;
-    FileCache cache_;
 
-    bool send_default_404_page_();
-    bool send_respond_(const std::filesystem::path& path,
-        const std::string& body);
+    // the file has a gzip variant, stored or compressed on the fly, so
+    // its responses carry 'Vary: Accept-Encoding'
+    bool vary_ = false;
+
+    // the mount and the type of the requested file
+    const Mount* mount_ = nullptr;
+    const MimeType* mime_ = nullptr;
+
+    // a HEAD request, answered with the head the GET would get
+    bool head_only_;
+
+    // when the first byte was handed to the socket, 0 before
+    uint64_t first_send_ = 0;
+
+    // of the response, for the access log
+    int status_ = 0;
+    size_t sent_ = 0;
+
+    bool wait_writable_();
+    bool send_iov_(iovec* iov, size_t count, int flags);
+    bool send_all_(const char* head, size_t head_length,
+        const char* body, size_t body_length);
+    bool send_file_(int fd, size_t offset, size_t length);
+    bool send_body_(const FileCache::Body& body, const char* head,
+        size_t head_length, size_t offset, size_t length);
+    void write_head_(ResponseWriter& writer, int status);
+    void write_validators_(ResponseWriter& writer,
+        const FileCache::Entry& entry, std::string_view etag) const;
+
+    bool send_error_page_(int status, bool keep_alive);
+    bool send_respond_(const FileCache::Entry& entry,
+        const FileCache::Body& body);
+    bool send_partial_(const FileCache::Entry& entry,
+        const FileCache::Body& body, const ByteRange& range);
+    bool send_multipart_(const FileCache::Entry& entry,
+        const FileCache::Body& body, const RangeSet& set);
+    bool send_gzip_stream_(const FileCache::Entry& entry,
+        std::string_view etag);
+    bool send_range_not_satisfiable_(const FileCache::Body& body);
+    bool send_not_modified_(const FileCache::Entry& entry,
+        std::string_view etag);
+    bool not_modified_(const FileCache::Entry& entry,
+        std::string_view etag) const;
+    RangeResult range_of_(const FileCache::Entry& entry,
+        const FileCache::Body& body, RangeSet& set) const;
+    bool reply_gzip_stream_(const FileCache::Entry& entry);
+    bool reply_status_();
 
 public:
-    Responser(const Config& cfg, const HttpRequest& request,
-        const nano::sock_t& sock);
+    Responser(const RuntimeConfig& cfg, FileCache& cache,
+        const HttpRequest& request, const nano::sock_t& sock);
+
+    // the strings of the response were taken from the RequestArena, it is
+    // reset for the next request
+    ~Responser();
 
     bool reply();
 
+    // from Metrics::now(), ends the respond stage and starts the flush
+    inline uint64_t first_send() const noexcept { return first_send_; }
+
+    // the status of the response and the bytes of it sent
+    inline int status() const noexcept { return status_; }
+    inline size_t sent() const noexcept { return sent_; }
+
+    // replies a request that cannot be served, the connection is closed
+    bool reply_error(int status);
+
 }; // class Responser
 
 } // namespace webstab
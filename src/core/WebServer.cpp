@@ -28,23 +28,111 @@
 
 // C++
 #include <iostream>
+#include <optional>
 
 // os
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 // WebStable
+#include "core/Metrics.h"
+#include "core/PollPoller.h"
 #include "core/Responser.h"
 #include "http/RequestReceiver.h"
 
 namespace webstab {
 
+namespace {
+
+// room made in the receive buffer for each recv()
+constexpr size_t RecvLength = 8192;
+
+// connections accepted for each wakeup before the other events are
+// handled, the rest wait for the next turn of the loop
+constexpr size_t AcceptBatch = 64;
+
+// milliseconds before the listener is tried again when no descriptor is
+// left to accept with
+constexpr int AcceptRetryMs = 100;
+
+// sockets returned by the workers read from the pipe at once
+constexpr size_t InsertBatch = 64;
+
+// written to the same pipe by the timer, the main loop then closes the
+// sockets that timed out
+constexpr nano::sock_t ExpireMark = -1;
+
+// the answer of the main loop while the server is over its limits
+constexpr char Unavailable[] = "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Length: 0\r\nConnection: close\r\nRetry-After: 1\r\n\r\n";
+
+// write end of the pipe that wakes up the reloader
+int reload_fd_ = -1;
+
+void on_sighup_(int) {
+    int saved_errno = errno;
+    char c = 0;
+    [[maybe_unused]] ssize_t ret = ::write(reload_fd_, &c, 1);
+    errno = saved_errno;
+}
+
+// reopened on SIGUSR1, after the file was rotated
+AccessLog* rotate_log_ = nullptr;
+
+void on_sigusr1_(int) {
+    if (rotate_log_ != nullptr) rotate_log_->reopen();
+}
+
+// the respond and flush stages of a reply that started at 'start'
+void record_reply_(const Responser& responser, uint64_t start) {
+    uint64_t first_send = responser.first_send();
+    if (first_send == 0) return;
+    Metrics::record(Stage::Respond, start, first_send);
+    Metrics::record(Stage::Flush, first_send, Metrics::now());
+}
+
+} // anonymous namespace
+
+// what a worker holds of a connection during its turn. parked with the
+// socket when a request arrived in part, otherwise kept by the thread
+// and reused for the next socket
+struct WebServer::Connection {
+    // the receiver reads the body policy of this snapshot
+    std::shared_ptr<const RuntimeConfig> runtime;
+    HttpRequest request;
+    std::optional<RequestReceiver> receiver;
+
+    // by when the head of the request must be complete, from
+    // Metrics::now(). 0 until the request first waits for it
+    uint64_t deadline = 0;
+
+    void start(std::shared_ptr<const RuntimeConfig> snapshot) {
+        runtime = std::move(snapshot);
+        receiver.emplace(request, runtime->body_policy());
+        deadline = 0;
+    }
+
+    // returns the buffer and the snapshot before the object waits for
+    // its next socket
+    void finish() {
+        receiver.reset();
+        request = HttpRequest();
+        runtime.reset();
+    }
+};
+
 iohub::PollerBase* WebServer::select_poller_(const std::string& poller_name) {
     if (poller_name == "select") {
         poller_event_ = iohub::IOHUB_IN;
         return new iohub::Select;
     } else if (poller_name == "poll") {
         poller_event_ = POLLIN;
-        return new iohub::Poll;
+        return new PollPoller;
     } else if (poller_name == "epoll") {
         poller_event_ = EPOLLIN | EPOLLET;
         return new iohub::Epoll;
@@ -54,115 +142,500 @@ iohub::PollerBase* WebServer::select_poller_(const std::string& poller_name) {
     }
 }
 
-bool WebServer::insert_sock_(nano::sock_t sock) {
-    return -1 != ::write(insert_pipe_[1], &sock, sizeof(sock));
+AccessLog* WebServer::open_access_log_() const {
+    std::string path = config_.access_log();
+    if (path.empty()) return nullptr;
+    std::string overflow_name = config_.access_log_overflow();
+    AccessLog::Overflow overflow;
+    if (overflow_name == "drop") {
+        overflow = AccessLog::Overflow::Drop;
+    } else if (overflow_name == "block") {
+        overflow = AccessLog::Overflow::Block;
+    } else {
+        std::cerr << "unsupported access_log_overflow: " << overflow_name
+            << std::endl;
+        exit(1);
+    }
+    try {
+        return new AccessLog(path, config_.access_log_buffer(), overflow);
+    } catch (const std::exception& e) {
+        std::cerr << "Access log: " << e.what() << std::endl;
+        exit(1);
+    }
 }
 
-WebServer::WebServer(const Config& config)
-        : config_(config), insert_pipe_{-1, -1},
-        thread_pool_(config_.threads_num()),
-        poller_(select_poller_(config_.poller())),
-        timer_(config_.keepalive_timeout()) {
-    // make pipe
-    if (-1 == ::pipe(insert_pipe_))
-        throw std::strerror(errno);
-    ::signal(SIGPIPE, SIG_IGN);
-    poller_->insert(insert_pipe_[0], poller_event_);
-    // listen
+void WebServer::listen_() {
     nano::AddrPort listen = config_.get_listen();
     server_socket_.reuse_addr(true);
     server_socket_.set_blocking(false);
-    server_socket_.set_option(SOL_SOCKET, SO_LINGER, linger{1, 1});
+    // the accepted sockets inherit the [tcp] options from the listener,
+    // the buffer sizes are set before listen() to scale the window
+    if (config_.tcp_linger() >= 0)
+        server_socket_.set_option(SOL_SOCKET, SO_LINGER,
+            linger{1, config_.tcp_linger()});
+    if (config_.tcp_nodelay())
+        server_socket_.set_option(IPPROTO_TCP, TCP_NODELAY, 1);
+    if (config_.tcp_sndbuf() > 0)
+        server_socket_.set_option(SOL_SOCKET, SO_SNDBUF,
+            static_cast<int>(config_.tcp_sndbuf()));
+    if (config_.tcp_rcvbuf() > 0)
+        server_socket_.set_option(SOL_SOCKET, SO_RCVBUF,
+            static_cast<int>(config_.tcp_rcvbuf()));
+    if (config_.tcp_notsent_lowat() > 0)
+        server_socket_.set_option(IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+            static_cast<int>(config_.tcp_notsent_lowat()));
+    // accepted only once the first data arrived, and then handed to a
+    // worker without a turn in the poller
+    if (config_.defer_accept() > 0)
+        server_socket_.set_option(IPPROTO_TCP, TCP_DEFER_ACCEPT,
+            config_.defer_accept());
+    if (config_.fastopen() > 0)
+        server_socket_.set_option(IPPROTO_TCP, TCP_FASTOPEN,
+            config_.fastopen());
     try {
         server_socket_.bind(listen.addr(), listen.port());
         poller_->insert(server_socket_.get(), poller_event_);
-        server_socket_.listen();
+        server_socket_.listen(config_.backlog());
     } catch (const std::exception& e) {
         std::cerr << "Web server start failed: " << e.what() << std::endl;
         exit(-2);
     }
     std::cout << "Web server listening on " << listen.to_string() << std::endl;
+}
+
+bool WebServer::accept_batch_(nano::sock_t serv) {
+    accept_starved_ = false;
+    if (reserve_fd_ == -1)
+        reserve_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    // the accepted sockets inherit the [tcp] options from the listener
+    for (size_t i = 0; i < AcceptBatch; ++i) {
+        sockaddr_storage addr;
+        socklen_t length = sizeof(addr);
+        nano::sock_t sock = ::accept4(serv, reinterpret_cast<sockaddr*>(&addr),
+            &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock == INVALID_SOCKET) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EMFILE && errno != ENFILE)
+                return false;
+            if (reserve_fd_ == -1) {
+                // the queue is not drained, an edge-triggered poller
+                // would not report it again
+                accept_starved_ = true;
+                return true;
+            }
+            // out of descriptors, the reserve makes room to turn one
+            // connection away instead of leaving the queue to stall
+            ::close(reserve_fd_);
+            sock = ::accept4(serv, nullptr, nullptr,
+                SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (sock != INVALID_SOCKET) {
+                Metrics::add(Counter::ConnectionsAccepted);
+                turn_away_(sock);
+            }
+            reserve_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+            if (sock == INVALID_SOCKET) return false;
+            continue;
+        }
+        Metrics::add(Counter::ConnectionsAccepted);
+        if (!limiter_.admit(sock, addr)) {
+            turn_away_(sock);
+        } else if (defer_accept_) {
+            dispatch_(sock);
+        } else if (!watch_(sock)) {
+            close_sock_(sock);
+        } else {
+            // closed like an idle connection if nothing arrives
+            timer_.timing(sock);
+        }
+    }
+    // more may be waiting, edge-triggered pollers will not report them
+    return true;
+}
+
+bool WebServer::watch_(nano::sock_t sock) noexcept {
+    try {
+        poller_->insert(sock, poller_event_);
+        return true;
+    } catch (const iohub::IOHubExcept& e) {
+        return false;
+    }
+}
+
+void WebServer::close_expired_() {
+    // only the main loop changes the poller, so a socket is closed here
+    // and never while the poller still reports it. one that is not in
+    // the poller was timed by a worker and is still in the insert pipe,
+    // it is timed again and expires once it is watched
+    timer_.take_expired(expired_);
+    for (nano::sock_t sock : expired_) {
+        try {
+            poller_->erase(sock);
+        } catch (const iohub::IOHubExcept& e) {
+            timer_.timing(sock);
+            continue;
+        }
+        close_sock_(sock);
+    }
+    expired_.clear();
+}
+
+void WebServer::dispatch_(nano::sock_t sock) {
+    if (max_queue_ && thread_pool_.queued() >= max_queue_) {
+        // the workers are behind, an answer now keeps the wait of the
+        // requests already queued from growing
+        shed_(sock);
+        close_sock_(sock);
+        return;
+    }
+    thread_pool_.push(sock);
+}
+
+void WebServer::shed_(nano::sock_t sock) {
+    // what the client sent is read first, a close with unread data would
+    // reset the connection and the answer with it
+    char discard[4096];
+    for (int i = 0; i < 4; ++i)
+        if (::recv(sock, discard, sizeof(discard), MSG_DONTWAIT) <= 0) break;
+    [[maybe_unused]] ssize_t ret = ::send(sock, Unavailable,
+        sizeof(Unavailable) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    Metrics::add_status(503);
+    Metrics::add(Counter::ConnectionsShed);
+}
+
+void WebServer::turn_away_(nano::sock_t sock) {
+    // not counted by the limiter
+    shed_(sock);
+    nano::close_socket(sock);
+    Metrics::add(Counter::ConnectionsClosed);
+}
+
+bool WebServer::insert_sock_(nano::sock_t sock) {
+    return -1 != ::write(insert_pipe_[1], &sock, sizeof(sock));
+}
+
+void WebServer::close_sock_(nano::sock_t sock) {
+    this->timer_.cancel(sock);
+    unpark_(sock);
+    limiter_.release(sock);
+    nano::close_socket(sock);
+    Metrics::add(Counter::ConnectionsClosed);
+}
+
+void WebServer::park_(nano::sock_t sock,
+        std::unique_ptr<Connection> connection) {
+    std::lock_guard<std::mutex> lock(parked_mutex_);
+    parked_[sock] = std::move(connection);
+    parked_count_.store(parked_.size(), std::memory_order_relaxed);
+}
 
-    // keep-alive timer
+std::unique_ptr<WebServer::Connection> WebServer::unpark_(nano::sock_t sock) {
+    // a socket is parked before it is handed on, whoever gets it next
+    // sees the count
+    if (parked_count_.load(std::memory_order_relaxed) == 0) return nullptr;
+    std::lock_guard<std::mutex> lock(parked_mutex_);
+    auto it = parked_.find(sock);
+    if (it == parked_.end()) return nullptr;
+    std::unique_ptr<Connection> connection = std::move(it->second);
+    parked_.erase(it);
+    parked_count_.store(parked_.size(), std::memory_order_relaxed);
+    return connection;
+}
+
+std::shared_ptr<const RuntimeConfig> WebServer::runtime_snapshot_() const {
+    return std::atomic_load(&runtime_);
+}
+
+void WebServer::reload_() {
+    // parsed and compiled on the reloader thread, then published at once.
+    // requests in flight finish on the snapshot they started with
+    std::shared_ptr<const RuntimeConfig> runtime;
+    try {
+        Config config = Config::load(config_.file());
+        runtime = std::make_shared<const RuntimeConfig>(config);
+        nano::AddrPort listen = config.get_listen();
+        if (listen.to_string() != config_.get_listen().to_string()
+                || config.threads_num() != config_.threads_num()
+                || config.poller() != config_.poller()
+                || config.backlog() != config_.backlog()
+                || config.defer_accept() != config_.defer_accept()
+                || config.fastopen() != config_.fastopen()
+                || config.max_connections() != config_.max_connections()
+                || config.max_connections_per_ip()
+                    != config_.max_connections_per_ip()
+                || config.max_queue() != config_.max_queue()
+                || !config.same_tcp(config_)
+                || config.access_log() != config_.access_log()
+                || config.access_log_buffer() != config_.access_log_buffer()
+                || config.access_log_overflow()
+                    != config_.access_log_overflow())
+            std::cerr << "listen, backlog, defer_accept, fastopen, "
+                "the connection limits, threads_num, poller, access_log "
+                "and [tcp] take effect after a restart" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Reload failed, the configuration is unchanged: "
+            << e.what() << std::endl;
+        return;
+    }
+    std::shared_ptr<const RuntimeConfig> old = runtime_snapshot_();
+    std::atomic_store(&runtime_, runtime);
+
+    // cached files are kept unless the mounts point somewhere else, or
+    // load their files under other policies
+    if (!runtime->same_files(*old))
+        file_cache_.clear();
+    file_cache_.set_capacity(runtime->cache_size());
+    timer_.resize(runtime->keepalive_timeout());
+    std::cout << "Configuration reloaded" << std::endl;
+}
+
+WebServer::WebServer(const Config& config)
+        : config_(config), insert_pipe_{-1, -1},
+        thread_pool_(config_.threads_num()),
+        poller_(select_poller_(config_.poller())),
+        timer_(config_.keepalive_timeout()),
+        limiter_(config_.max_connections(), config_.max_connections_per_ip()),
+        max_queue_(config_.max_queue()),
+        defer_accept_(config_.defer_accept() > 0),
+        runtime_(std::make_shared<const RuntimeConfig>(config_)),
+        reload_pipe_{-1, -1},
+        file_cache_(runtime_->cache_size()),
+        access_log_(open_access_log_()) {
+    // make pipe, the main loop drains it without blocking
+    if (-1 == ::pipe2(insert_pipe_, O_CLOEXEC))
+        throw std::strerror(errno);
+    ::fcntl(insert_pipe_[0], F_SETFL, O_NONBLOCK);
+    ::signal(SIGPIPE, SIG_IGN);
+    reserve_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    // SIGHUP reloads the configuration file
+    if (-1 == ::pipe2(reload_pipe_, O_CLOEXEC))
+        throw std::strerror(errno);
+    reload_fd_ = reload_pipe_[1];
+    struct sigaction action {};
+    action.sa_handler = on_sighup_;
+    action.sa_flags = SA_RESTART;
+    ::sigemptyset(&action.sa_mask);
+    ::sigaction(SIGHUP, &action, nullptr);
+
+    // SIGUSR1 reopens the access log
+    if (access_log_) {
+        rotate_log_ = access_log_.get();
+        action.sa_handler = on_sigusr1_;
+        ::sigaction(SIGUSR1, &action, nullptr);
+    }
+    poller_->insert(insert_pipe_[0], poller_event_);
+    listen_();
+
+    // keep-alive timer, it wakes the main loop to close what timed out
+    timer_.set_on_expire([this]() { insert_sock_(ExpireMark); });
     timer_.start();
 
+    // read when the metrics are exposed
+    Metrics::add_gauge("webstable_queued_connections",
+        "Connections waiting for a worker thread.",
+        [this]() { return thread_pool_.queued(); });
+    Metrics::add_gauge("webstable_idle_connections",
+        "Keep-alive connections waiting for a request.",
+        [this]() { return timer_.size(); });
+    Metrics::add_gauge("webstable_timer_bytes",
+        "Estimated heap bytes held by the keep-alive timer.",
+        [this]() { return timer_.memory(); });
+    Metrics::add_gauge("webstable_cache_bytes",
+        "Bytes of files held in the cache.",
+        [this]() { return file_cache_.size(); });
+    Metrics::add_gauge("webstable_cache_files",
+        "Files held in the cache.",
+        [this]() { return file_cache_.count(); });
+
     thread_pool_.set_task([this](nano::sock_t sock) {
-        char buf[10240]{};
-        HttpRequest request;
-        RequestReceiver ha(request);
+        // a request received in part goes on where its last turn stopped,
+        // on the configuration it started with
+        thread_local std::unique_ptr<Connection> spare;
+        std::unique_ptr<Connection> connection = unpark_(sock);
+        if (!connection) {
+            connection = spare ? std::move(spare)
+                : std::make_unique<Connection>();
+            connection->start(runtime_snapshot_());
+        }
+        const RuntimeConfig* runtime = connection->runtime.get();
+        HttpRequest& request = connection->request;
+        RequestReceiver& receiver = *connection->receiver;
+        auto end_turn = [&]() {
+            connection->finish();
+            spare = std::move(connection);
+        };
+
+        // a request is parsed from when the worker turns to it
+        uint64_t parse_start = Metrics::now();
+
+        // the peer is looked up once per turn, for the access log only
+        char peer[PeerNameLength] = "";
+        auto log_request = [&](const Responser& responser) {
+            if (!access_log_) return;
+            if (peer[0] == '\0') AccessLog::peer_name(sock, peer);
+            access_log_->log(peer, request, responser.status(),
+                responser.sent(), (Metrics::now() - parse_start) / 1000);
+        };
+
         while (true) {
-            int recv_length = 0;
-            try {
-                recv_length = nano::recv_msg(sock, buf, sizeof(buf) - 1);
-            } catch (const nano::NanoExcept &e) { (void)0; }
-
-            if (recv_length == 0) {
-                this->timer_.cancel(sock);
-                nano::close_socket(sock);
+            if (receiver.bad()) {
+                Metrics::add(Counter::Requests);
+                Responser responser(*runtime, file_cache_, request, sock);
+                responser.reply_error(receiver.error());
+                log_request(responser);
+                close_sock_(sock);
+                end_turn();
                 return;
-            } else if (recv_length == -1) {
-                // TODO: receive done
-                if (Responser(config_, request, sock).reply()
-                        && insert_sock_(sock)) {
-                    this->timer_.timing(sock);
-                } else {
-                    this->timer_.cancel(sock);
-                    nano::close_socket(sock);
+            } else if (receiver.done()) {
+                // request complete, reply and keep the connection alive
+                Metrics::add(Counter::Requests);
+                uint64_t reply_start = Metrics::now();
+                Metrics::record(Stage::Parse, parse_start, reply_start);
+                Responser responser(*runtime, file_cache_, request, sock);
+                bool keep_alive = responser.reply();
+                record_reply_(responser, reply_start);
+                log_request(responser);
+                if (!keep_alive) {
+                    close_sock_(sock);
+                    end_turn();
+                    return;
                 }
-                break;
+                receiver.next();
+                connection->deadline = 0;
+                parse_start = Metrics::now();
+                continue;
+            }
+
+            // receive into the buffer of the connection, or move a large
+            // body to its temporary file
+            ssize_t recv_length = -1;
+            if (receiver.splicing()) {
+                recv_length = receiver.splice_body(sock);
             } else {
-                // TODO: append message
-                ha.append(buf);
+                try {
+                    recv_length = nano::recv_msg(sock,
+                        receiver.prepare(RecvLength), RecvLength);
+                } catch (const nano::NanoExcept &e) { (void)0; }
+                if (recv_length > 0)
+                    receiver.commit(recv_length);
             }
+
+            if (recv_length > 0) {
+                Metrics::add(Counter::BytesIn,
+                    static_cast<uint64_t>(recv_length));
+                continue;
+            } else if (recv_length == 0 || errno != EAGAIN) {
+                // closed by peer or failed
+                close_sock_(sock);
+                end_turn();
+                return;
+            } else if (receiver.idle()) {
+                // all requests replied, wait for the next in the poller.
+                // timed first, so that the main loop cancels it when the
+                // next request arrives
+                this->timer_.timing(sock);
+                if (!insert_sock_(sock)) close_sock_(sock);
+                end_turn();
+                return;
+            }
+
+            // the rest of the request is not here yet, it is waited for
+            // in the poller and the thread goes on to other connections.
+            // a head that trickles in is cut off at its deadline
+            uint64_t now = Metrics::now();
+            if (!receiver.head_done() && connection->deadline == 0) {
+                connection->deadline = now + runtime->header_timeout_ns();
+            } else if (!receiver.head_done() && now >= connection->deadline) {
+                Metrics::add(Counter::Requests);
+                Responser responser(*runtime, file_cache_, request, sock);
+                responser.reply_error(408);
+                log_request(responser);
+                close_sock_(sock);
+                end_turn();
+                return;
+            }
+            park_(sock, std::move(connection));
+            this->timer_.timing(sock);
+            if (!insert_sock_(sock)) close_sock_(sock);
+            return;
         }
     });
+
+    // reloads once the server is set up, a SIGHUP before waits in the
+    // pipe. runs until the destructor closes the write end
+    reloader_ = std::thread([this]() {
+        char c;
+        while (::read(reload_pipe_[0], &c, 1) > 0)
+            reload_();
+    });
 }
 
 WebServer::~WebServer() {
+    // the reloader uses the members, it finishes a reload in progress
+    // and is joined before they go
+    ::signal(SIGHUP, SIG_IGN);
+    reload_fd_ = -1;
+    ::close(reload_pipe_[1]);
+    if (reloader_.joinable()) reloader_.join();
+    ::close(reload_pipe_[0]);
+    Metrics::clear_gauges();
     server_socket_.close();
     poller_->close();
     thread_pool_.shutdown();
     timer_.stop();
+    if (reserve_fd_ != -1) ::close(reserve_fd_);
     std::cout << "webserver closed" << std::endl;
 }
 
 int WebServer::exec() {
     nano::sock_t serv = server_socket_.get();
     std::vector<iohub::fd_event_t> fd_events;
+    // the last batch was full, the listener is polled without waiting,
+    // or after a pause when it stopped for want of descriptors
+    bool accept_pending = false;
     while (true) {
-        // main loop
-        poller_->wait(fd_events);
+        // main loop, a SIGHUP may interrupt the wait
+        try {
+            int timeout = !accept_pending ? -1
+                : accept_starved_ ? AcceptRetryMs : 0;
+            poller_->wait(fd_events, timeout);
+        } catch (const iohub::IOHubExcept& e) {
+            if (errno == EINTR) continue;
+            throw;
+        }
+        uint64_t woken = Metrics::now();
+        bool accept_ready = accept_pending;
         for (const auto& [fd, _] : fd_events) {
             if (fd == serv) {
-                // new link
-                while (true) {
-                    // accept new link
-                    auto sock = nano::accept_from(serv, nullptr, nullptr);
-                    struct linger tmp = {1, 1};
-                    setsockopt(sock, SOL_SOCKET, SO_LINGER, &tmp, sizeof(tmp));
-                    if (sock == INVALID_SOCKET) break;
-                    nano::set_blocking(sock, false);
-                    poller_->insert(sock, poller_event_);
-                }
+                // new links, accepted after the other events
+                accept_ready = true;
             } else if (fd == insert_pipe_[0]) {
-                // insert to poller
-                nano::sock_t add_sock = INVALID_SOCKET;
-                ssize_t read_result = ::read(fd, &add_sock, sizeof(add_sock));
-                if (read_result > 0) {
-                    try {
-                        poller_->insert(add_sock, poller_event_);
-                    } catch (const iohub::IOHubExcept& e) {
-                        timer_.cancel(add_sock);
-                        // printf(e.what());
+                // insert to poller, every socket written so far
+                nano::sock_t socks[InsertBatch];
+                ssize_t read_result;
+                while ((read_result = ::read(fd, socks, sizeof(socks))) > 0) {
+                    size_t count = static_cast<size_t>(read_result)
+                        / sizeof(nano::sock_t);
+                    for (size_t i = 0; i < count; ++i) {
+                        if (socks[i] == ExpireMark)
+                            close_expired_();
+                        else if (!watch_(socks[i]))
+                            close_sock_(socks[i]);
                     }
                 }
             } else {
-                // link fd
+                // link fd, the poller may report one it no longer has
                 timer_.cancel(fd);
-                poller_->erase(fd);
-                thread_pool_.push(fd);
+                try {
+                    poller_->erase(fd);
+                } catch (const iohub::IOHubExcept& e) {
+                    continue;
+                }
+                dispatch_(fd);
             }
         }
+        accept_pending = accept_ready && accept_batch_(serv);
+        Metrics::record(Stage::Loop, woken, Metrics::now());
     }
     return 0;
 }
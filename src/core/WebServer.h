@@ -29,7 +29,12 @@
 #define WEBSTABLE_CORE_WEBSERVER_H
 
 // C++
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 // nanonet
 #include "nanonet.h"
@@ -39,12 +44,18 @@
 
 // WebStable
 #include "app/Config.h"
+#include "app/RuntimeConfig.h"
+#include "core/AccessLog.h"
+#include "core/ConnectionLimiter.h"
+#include "file/FileCache.h"
 #include "thread/ThreadPool.h"
 #include "thread/TimerWheel.h"
 
 namespace webstab {
 
 class WebServer final {
+    struct Connection;
+
     Config config_;
     int insert_pipe_[2];
     int poller_event_;
@@ -52,10 +63,54 @@ class WebServer final {
     std::unique_ptr<iohub::PollerBase> poller_;
     nano::ServerSocket server_socket_;
     TimerWheel timer_;
+    std::vector<nano::sock_t> expired_;
+
+    // limits of the connections, fixed until a restart
+    ConnectionLimiter limiter_;
+    size_t max_queue_;
+    bool defer_accept_;
+
+    // closed when the process is out of descriptors, so that a connection
+    // can still be accepted and turned away
+    int reserve_fd_ = -1;
+
+    // out of descriptors without the reserve, the listener is tried again
+    // after a pause instead of at once
+    bool accept_starved_ = false;
+
+    // the running configuration, replaced as a whole on SIGHUP. workers
+    // hold a reference for as long as they use it, so a snapshot is
+    // released by whoever drops it last
+    std::shared_ptr<const RuntimeConfig> runtime_;
+    int reload_pipe_[2];
+    FileCache file_cache_;
+    std::thread reloader_;
+
+    // nullptr when 'access_log' is not set
+    std::unique_ptr<AccessLog> access_log_;
+
+    // requests received in part, by socket, while their connections wait
+    // in the poller for the rest. the count spares the lock when empty
+    std::mutex parked_mutex_;
+    std::unordered_map<nano::sock_t, std::unique_ptr<Connection>> parked_;
+    std::atomic<size_t> parked_count_ = 0;
 
 private:
     iohub::PollerBase* select_poller_(const std::string& poller_name);
+    AccessLog* open_access_log_() const;
+    void listen_();
+    bool accept_batch_(nano::sock_t serv);
+    bool watch_(nano::sock_t sock) noexcept;
+    void close_expired_();
+    void dispatch_(nano::sock_t sock);
+    void shed_(nano::sock_t sock);
+    void turn_away_(nano::sock_t sock);
     bool insert_sock_(nano::sock_t sock);
+    void close_sock_(nano::sock_t sock);
+    void park_(nano::sock_t sock, std::unique_ptr<Connection> connection);
+    std::unique_ptr<Connection> unpark_(nano::sock_t sock);
+    std::shared_ptr<const RuntimeConfig> runtime_snapshot_() const;
+    void reload_();
 
 public:
     WebServer(const Config& config);
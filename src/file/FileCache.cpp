@@ -27,110 +27,242 @@
 #include "FileCache.h"
 
 // C
-#include <ctime>
-
-// C++
-#include <filesystem>
-#include <fstream>
-#include <functional>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
 
 // Linux
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+// WebStable
+#include "core/Metrics.h"
+#include "http/Gzip.h"
+#include "http/HttpDate.h"
 
 namespace webstab {
 
 namespace {
 
-std::time_t file_update_time(const char* path) {
-    struct stat file_stat {};
-    if (::stat(path, &file_stat) == -1)
-        throw 404;
-    return static_cast<std::time_t>(file_stat.st_mtime);
+// the entry is of the file as it is now on the disk, and so is its
+// precompressed variant when it has one
+bool is_latest(const FileCache::Entry& entry, const struct stat& st,
+        bool compressible) {
+    if (entry.mtime != st.st_mtime || entry.inode != st.st_ino
+            || entry.identity.size != static_cast<size_t>(st.st_size)
+            || entry.compressible != compressible)
+        return false;
+    if (entry.gzip_path.empty()) return true;
+    struct stat gzip_st {};
+    return ::stat(entry.gzip_path.c_str(), &gzip_st) == 0
+        && entry.gzip_mtime == gzip_st.st_mtime
+        && entry.gzip_inode == gzip_st.st_ino
+        && entry.gzip.size == static_cast<size_t>(gzip_st.st_size);
 }
 
-bool is_latest(const std::string& path, std::time_t time) {
-    std::time_t ftime = file_update_time(path.c_str());
-    return ftime < time;
+
+// bytes of an entry held in memory
+size_t charge(const FileCache::Entry& entry) {
+    return entry.identity.content.size() + entry.gzip.content.size();
 }
 
-long int read_file(const std::string& path, std::string& content) {
-    try {
-        std::ifstream file(path, std::ios::binary);
-        size_t fsize = std::filesystem::file_size(path);
-        if (!file.is_open()) return -1L;
-        content.resize(fsize);
-        file.read(&(content[0]), fsize);
-        file.close();
-        return fsize;
-    } catch (...) {
-        return -1L;
+bool read_file(int fd, std::string& content, size_t size) {
+    content.resize(size);
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t ret = ::pread(fd, &content[offset], size - offset, offset);
+        if (ret == -1 && errno == EINTR) continue;
+        if (ret <= 0) return false;
+        offset += static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+// opens 'path' into 'body', it is read into memory unless it is larger
+// than 'max_size'
+bool open_body(const std::string& path, size_t max_size,
+        FileCache::Body& body, struct stat& st) {
+    body.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (body.fd == -1) return false;
+    if (::fstat(body.fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return false;
+    body.size = static_cast<size_t>(st.st_size);
+    if (body.size <= max_size) {
+        bool success = read_file(body.fd, body.content, body.size);
+        ::close(body.fd);
+        body.fd = -1;
+        return success;
+    }
+    return true;
+}
+
+// a 'path.gz' not older than the file is served as its gzip variant,
+// in the manner of gzip_static
+bool open_static_gzip(const std::string& path, FileCache::Entry& entry) {
+    FileCache::Body& gzip = entry.gzip;
+    struct stat st {};
+    size_t max_size = entry.cached() ? SIZE_MAX : 0;
+    std::string gzip_path = path + ".gz";
+    if (open_body(gzip_path, max_size, gzip, st)
+            && st.st_size > 0 && st.st_mtime >= entry.mtime) {
+        entry.gzip_path = std::move(gzip_path);
+        entry.gzip_mtime = st.st_mtime;
+        entry.gzip_inode = st.st_ino;
+        return true;
+    }
+    if (gzip.fd != -1) ::close(gzip.fd);
+    gzip.fd = -1;
+    gzip.size = 0;
+    std::string().swap(gzip.content);
+    return false;
+}
+
+void prepare_gzip(const std::string& path, const CachePolicy& policy,
+        FileCache::Entry& entry) {
+    FileCache::Body& gzip = entry.gzip;
+    if (!open_static_gzip(path, entry)) {
+        // only the files held in memory are compressed, once, here
+        const FileCache::Body& identity = entry.identity;
+        if (!entry.cached() || !gzip_compress(identity.content.data(),
+                identity.size, policy.gzip_level, gzip.content))
+            return;
+        gzip.size = gzip.content.size();
+        if (gzip.size >= identity.size) {
+            gzip.size = 0;
+            std::string().swap(gzip.content);
+            return;
+        }
     }
+    // '"inode-size-mtime-gz"'
+    gzip.etag = entry.identity.etag;
+    gzip.etag.insert(gzip.etag.size() - 1, "-gz");
+}
+
+// the validators come from the opened file, so that they describe the
+// bytes that are sent even if the path is replaced meanwhile
+FileCache::EntryPtr load_file(const std::string& path,
+        const CachePolicy& policy, bool compressible) {
+    auto entry = std::make_shared<FileCache::Entry>();
+    struct stat st {};
+    if (!open_body(path, policy.max_file_size, entry->identity, st))
+        return nullptr;
+    entry->filepath = path;
+    entry->mtime = st.st_mtime;
+    entry->inode = st.st_ino;
+    entry->compressible = compressible;
+
+    // strong validator "inode-size-mtime"
+    char etag[64];
+    std::snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx\"",
+        static_cast<unsigned long>(st.st_ino),
+        static_cast<unsigned long>(st.st_size),
+        static_cast<unsigned long>(st.st_mtime));
+    entry->identity.etag = etag;
+
+    char date[HttpDateLength + 1];
+    format_http_date(st.st_mtime, date);
+    entry->last_modified = date;
+
+    if (compressible && policy.gzip_level > 0
+            && entry->identity.size >= policy.gzip_min_length)
+        prepare_gzip(path, policy, *entry);
+    return entry;
 }
 
 } // anonymous namespace
 
+FileCache::Body::~Body() {
+    if (fd != -1) ::close(fd);
+}
+
 FileCache::FileCache(size_t capacity) : capacity_(capacity), size_(0UL) {}
 
-bool FileCache::get_file(
-        const std::string& path,
-        std::string& result) noexcept {
+void FileCache::evict_() {
+    while (size_ > capacity_ && !list_.empty()) {
+        const Entry& del = *list_.back();
+        size_ -= charge(del);
+        map_.erase(del.filepath);
+        list_.pop_back();
+        Metrics::add(Counter::CacheEvictions);
+    }
+}
+
+FileCache::EntryPtr FileCache::get_file(const std::string& path,
+        const CachePolicy& policy, bool compressible) noexcept {
+    struct stat st {};
+    if (::stat(path.c_str(), &st) == -1 || !S_ISREG(st.st_mode))
+        return nullptr;
+
     rwlock_.lock_shared(); // rwlock lock read
     auto map_it = map_.find(path);
-    if (map_it != map_.end() && is_latest(path, map_it->second->time)) {
+    if (map_it != map_.end()
+            && is_latest(**map_it->second, st, compressible)) {
         // cache hit and cache is latest
-        // TODO: read cache
         lru_mutex_.lock(); // mutex lock
 
-        // update list and hashmap
-        if (map_it->second != list_.begin()) {
-            list_.emplace_front(std::move(*map_it->second));
-            list_.erase(map_it->second);
-            map_it->second = list_.begin();
-        }
-
-        // get content
-        const std::string& content = map_it->second->content;
+        // move to the front, the iterator in the map stays valid
+        list_.splice(list_.begin(), list_, map_it->second);
+        EntryPtr entry = *map_it->second;
 
         lru_mutex_.unlock(); // mutex unlock
-
-        // read cache
-        result = content; // copy content from cache
-
-        rwlock_.unlock_shared(); // rwlock unlock read
-    } else {
-        // cache miss or cache is not latest
-        // TODO: update cache
         rwlock_.unlock_shared(); // rwlock unlock read
-        rwlock_.lock(); // rwlock lock write
-
-        // read file
-        FileInfo fi {};
-        fi.filepath = path;
-        fi.time = std::time(nullptr);
-        long int fsize = read_file(path, fi.content);
-        if (fsize == -1) {
-            // read failed
-            rwlock_.unlock();
-            return false;
-        }
+        Metrics::add(Counter::CacheHits);
+        return entry;
+    }
+    rwlock_.unlock_shared(); // rwlock unlock read
 
-        // return result
-        result = fi.content;
+    // cache miss or cache is not latest, read and compress the file out
+    // of the lock
+    Metrics::add(Counter::CacheMisses);
+    EntryPtr entry;
+    try {
+        entry = load_file(path, policy, compressible);
+    } catch (...) {
+        return nullptr;
+    }
+    if (!entry || !entry->cached()) return entry;
 
-        lru_mutex_.lock(); // mutex lock
-        rwlock_.unlock(); // rwlock unlock write
-        list_.emplace_front(std::move(fi));
-        map_.emplace(path, list_.begin());
-        size_ += fsize;
-        while (size_ > capacity_) {
-            const FileInfo& del = list_.back();
-            size_ -= del.content.size();
-            map_.erase(del.filepath);
-            list_.pop_back();
+    std::lock_guard<std::shared_mutex> lock(rwlock_); // rwlock lock write
+    try {
+        map_it = map_.find(path);
+        if (map_it != map_.end()) {
+            // replace the outdated one
+            size_ -= charge(**map_it->second);
+            list_.erase(map_it->second);
+            map_.erase(map_it);
         }
-        lru_mutex_.unlock(); // mutex unlock
+        list_.push_front(entry);
+        map_.emplace(path, list_.begin());
+        size_ += charge(*entry);
+        evict_();
+    } catch (...) {
+        // not cached, but still served
     }
-    return true;
+    return entry;
+}
+
+void FileCache::clear() noexcept {
+    std::lock_guard<std::shared_mutex> lock(rwlock_); // rwlock lock write
+    map_.clear();
+    list_.clear();
+    size_ = 0UL;
+}
+
+void FileCache::set_capacity(size_t capacity) noexcept {
+    std::lock_guard<std::shared_mutex> lock(rwlock_); // rwlock lock write
+    capacity_ = capacity;
+    evict_();
+}
+
+size_t FileCache::size() noexcept {
+    std::shared_lock<std::shared_mutex> lock(rwlock_); // rwlock lock read
+    return size_;
+}
+
+size_t FileCache::count() noexcept {
+    std::shared_lock<std::shared_mutex> lock(rwlock_); // rwlock lock read
+    return map_.size();
 }
 
 } // namespace webstab
@@ -29,22 +29,79 @@
 #define WEBSTABLE_FILE_FILECACHE_H
 
 // C++
+#include <ctime>
 #include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <mutex>
 #include <shared_mutex>
 
+// Linux
+#include <sys/types.h>
+
 namespace webstab {
 
+// how the files of a mount are loaded
+struct CachePolicy {
+    // larger files are sent from an open descriptor instead
+    size_t max_file_size = 1024UL * 1024UL;
+
+    // gzip variants of compressible files, level 0 disables them
+    int gzip_level = 6;
+    size_t gzip_min_length = 256;
+};
+
 class FileCache {
-    // types
-    struct FileInfo {
-        std::string filepath;
-        std::time_t time;
+public:
+    // the bytes of one content coding of a file, in memory when the file
+    // is cached, otherwise sent from 'fd'
+    struct Body {
         std::string content;
+        int fd = -1;
+        size_t size = 0;
+        std::string etag;
+
+        Body() = default;
+        ~Body();
+        Body(const Body&) = delete;
+        Body& operator=(const Body&) = delete;
+
+        inline bool cached() const noexcept { return fd == -1; }
+    };
+
+    // a file loaded into the cache, never modified once shared
+    struct Entry {
+        std::string filepath;
+        Body identity;
+
+        // from a precompressed 'filepath.gz' next to the file, or
+        // compressed once when the file is loaded. empty when the file
+        // is not compressible or does not get smaller
+        Body gzip;
+
+        // the precompressed file the gzip variant was read from, empty
+        // when there is none, and what it was when it was read
+        std::string gzip_path;
+        std::time_t gzip_mtime = 0;
+        ino_t gzip_inode = 0;
+
+        // validators, generated once when the file is loaded
+        std::string last_modified;
+        std::time_t mtime = 0;
+        ino_t inode = 0;
+
+        // loaded for a compressible type, a gzip variant was considered
+        bool compressible = false;
+
+        inline bool cached() const noexcept { return identity.cached(); }
+        inline bool has_gzip() const noexcept { return !gzip.etag.empty(); }
     };
-    using List = std::list<FileInfo>;
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+private:
+    // types
+    using List = std::list<EntryPtr>;
     using HashMap = std::unordered_map<std::string, List::iterator>;
 
 private:
@@ -59,14 +116,33 @@ private:
     size_t capacity_;
     size_t size_;
 
+private:
+    void evict_();
+
 public:
+    // 'capacity' bytes are shared by the files of every mount
     explicit FileCache(size_t capacity = 100UL * 1024UL * 1024UL);
 
     // non-copyable
     FileCache(const FileCache&) = delete;
     FileCache& operator=(const FileCache&) = delete;
 
-    bool get_file(const std::string& key, std::string& result) noexcept;
+    // the entry of the regular file 'path', (re)loaded under 'policy'
+    // when it is missing or outdated. a gzip variant is prepared at load
+    // time when the file is 'compressible'. nullptr when the file cannot
+    // be opened
+    EntryPtr get_file(const std::string& path, const CachePolicy& policy,
+        bool compressible = false) noexcept;
+
+    // drops every entry, those in use stay valid until released
+    void clear() noexcept;
+
+    // evicts the least recently used files down to the new capacity
+    void set_capacity(size_t capacity) noexcept;
+
+    // bytes held in memory, and the number of files cached
+    size_t size() noexcept;
+    size_t count() noexcept;
 
 }; // class FileCache
 
@@ -0,0 +1,141 @@
+// File:     src/http/ByteRange.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ByteRange.h"
+
+// C++
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+// WebStable
+#include "http/HttpParser.h"
+
+namespace webstab {
+
+namespace {
+
+// more ranges than this that overlap or are out of order are ignored, they
+// would have the same bytes sent again and again
+constexpr size_t MaxUnorderedRanges = 2;
+
+std::string_view trim_(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+// a run of digits, saturated instead of overflowing
+bool parse_position_(std::string_view s, size_t& value) {
+    if (s.empty()) return false;
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (end != s.data() + s.size()) return false;
+    if (ec == std::errc::result_out_of_range)
+        value = std::numeric_limits<size_t>::max();
+    return true;
+}
+
+} // anonymous namespace
+
+RangeResult parse_range(std::string_view value, size_t size,
+        RangeSet& set) noexcept {
+    set.count = 0;
+    value = trim_(value);
+    if (value.size() < 6 || !iequals(value.substr(0, 6), "bytes="))
+        return RangeResult::Ignore;
+    value.remove_prefix(6);
+
+    bool any = false, ordered = true;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view spec = trim_(value.substr(0, comma));
+        value = comma == std::string_view::npos
+            ? std::string_view() : value.substr(comma + 1);
+        // empty list elements are allowed
+        if (spec.empty()) continue;
+
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos)
+            return RangeResult::Ignore;
+        std::string_view first_pos = spec.substr(0, dash);
+        std::string_view last_pos = spec.substr(dash + 1);
+        ByteRange range {};
+        if (first_pos.empty()) {
+            // suffix range, '-200' is the last 200 bytes
+            size_t suffix = 0;
+            if (!parse_position_(last_pos, suffix))
+                return RangeResult::Ignore;
+            any = true;
+            if (suffix == 0 || size == 0) continue;
+            range.first = suffix < size ? size - suffix : 0;
+            range.last = size - 1;
+        } else {
+            if (!parse_position_(first_pos, range.first))
+                return RangeResult::Ignore;
+            range.last = size - 1;
+            if (!last_pos.empty()) {
+                if (!parse_position_(last_pos, range.last)
+                    || range.last < range.first)
+                    return RangeResult::Ignore;
+                if (range.last >= size) range.last = size - 1;
+            }
+            any = true;
+            if (range.first >= size) continue;
+        }
+        if (set.count == MaxRanges)
+            return RangeResult::Ignore;
+        if (set.count && range.first <= set.ranges[set.count - 1].last)
+            ordered = false;
+        set.ranges[set.count++] = range;
+    }
+    if (!any) return RangeResult::Ignore;
+    if (!set.count) return RangeResult::NotSatisfiable;
+
+    if (!ordered) {
+        if (set.count > MaxUnorderedRanges)
+            return RangeResult::Ignore;
+        std::sort(set.ranges, set.ranges + set.count,
+            [](const ByteRange& a, const ByteRange& b) {
+                return a.first < b.first;
+            });
+    }
+    // overlapping and adjacent ranges are sent as one
+    size_t count = 1;
+    for (size_t i = 1; i < set.count; ++i) {
+        ByteRange& merged = set.ranges[count - 1];
+        const ByteRange& range = set.ranges[i];
+        if (range.first <= merged.last + 1)
+            merged.last = std::max(merged.last, range.last);
+        else
+            set.ranges[count++] = range;
+    }
+    set.count = count;
+    return RangeResult::Satisfiable;
+}
+
+} // namespace webstab
@@ -0,0 +1,69 @@
+// File:     src/http/ByteRange.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_BYTERANGE_H
+#define WEBSTABLE_HTTP_BYTERANGE_H
+
+// C++
+#include <cstddef>
+#include <string_view>
+
+namespace webstab {
+
+// at most this many ranges are served in one multipart/byteranges response,
+// a longer list is ignored and the whole representation is sent
+constexpr size_t MaxRanges = 16;
+
+// [first, last] of a representation, both inclusive
+struct ByteRange {
+    size_t first;
+    size_t last;
+
+    inline size_t length() const noexcept { return last - first + 1; }
+};
+
+struct RangeSet {
+    ByteRange ranges[MaxRanges];
+    size_t count = 0;
+};
+
+enum class RangeResult {
+    Ignore,         // not a valid 'bytes' range, serve the whole
+    Satisfiable,    // at least one range overlaps the representation
+    NotSatisfiable, // 416
+};
+
+// parses 'bytes=0-499, 500-, -200' against a representation of 'size'
+// bytes, the satisfiable ranges are clipped and stored in 'set'. ranges
+// that overlap or touch are merged, and a list of more than a few that
+// overlap or are out of order is ignored
+RangeResult parse_range(std::string_view value, size_t size,
+    RangeSet& set) noexcept;
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_BYTERANGE_H
@@ -0,0 +1,181 @@
+// File:     src/http/ChunkedDecoder.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ChunkedDecoder.h"
+
+// C
+#include <cstring>
+
+// C++
+#include <algorithm>
+
+namespace webstab {
+
+namespace {
+
+// trailers larger than this make the body malformed
+constexpr size_t MaxTrailersLength = 8192;
+
+inline int hex_digit_(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+} // anonymous namespace
+
+ssize_t ChunkedDecoder::decode(char* buf, size_t& len) {
+    // +----------------------------------+
+    // | chunked body example             |
+    // +----------------------------------+
+    // | 5;name=value\r\n                 |
+    // | hello\r\n                        |
+    // | 0\r\n                            |
+    // | Trailer: value\r\n               |
+    // | \r\n                             |
+    // +----------------------------------+
+    size_t src = 0, dst = 0, trailer = 0;
+    while (src < len) {
+        char c = buf[src];
+        switch (state_) {
+        case Size: {
+            int digit = hex_digit_(c);
+            if (digit != -1) {
+                // the length must fit in size_t
+                if (chunk_remaining_ >> (sizeof(size_t) * 8 - 4))
+                    return -1;
+                chunk_remaining_ = (chunk_remaining_ << 4) | digit;
+                has_digit_ = true;
+            } else if (!has_digit_) {
+                return -1;
+            } else if (c == ';' || c == ' ' || c == '\t') {
+                state_ = Extension;
+            } else if (c == '\r') {
+                state_ = SizeLF;
+            } else if (c == '\n') {
+                state_ = chunk_remaining_ ? Data : TrailerStart;
+            } else {
+                return -1;
+            }
+            ++src;
+            break;
+        }
+        case Extension:
+            if (c == '\r') state_ = SizeLF;
+            else if (c == '\n') state_ = chunk_remaining_ ? Data : TrailerStart;
+            ++src;
+            break;
+        case SizeLF:
+            if (c != '\n') return -1;
+            state_ = chunk_remaining_ ? Data : TrailerStart;
+            ++src;
+            break;
+        case Data: {
+            // move the data over the framing before it
+            size_t length = std::min(len - src, chunk_remaining_);
+            if (dst != src)
+                std::memmove(buf + dst, buf + src, length);
+            src += length;
+            dst += length;
+            chunk_remaining_ -= length;
+            if (chunk_remaining_ == 0)
+                state_ = DataCR;
+            break;
+        }
+        case DataCR:
+            if (c == '\r') {
+                state_ = DataLF;
+            } else if (c == '\n') {
+                state_ = Size;
+                has_digit_ = false;
+            } else {
+                return -1;
+            }
+            ++src;
+            break;
+        case DataLF:
+            if (c != '\n') return -1;
+            state_ = Size;
+            has_digit_ = false;
+            ++src;
+            break;
+        case TrailerStart:
+            if (c == '\r') {
+                state_ = EndLF;
+            } else if (c == '\n') {
+                state_ = End;
+            } else {
+                // a trailer line, taken whole by the next state
+                state_ = Trailer;
+                break;
+            }
+            ++src;
+            break;
+        case Trailer: {
+            // the rest of the line at once, kept in the buffer
+            const char* lf = static_cast<const char*>(
+                std::memchr(buf + src, '\n', len - src));
+            size_t length = lf ? lf + 1 - (buf + src) : len - src;
+            if (trailers_length_ + length > MaxTrailersLength)
+                return -1;
+            if (dst + trailer != src)
+                std::memmove(buf + dst + trailer, buf + src, length);
+            trailers_length_ += length;
+            trailer += length;
+            src += length;
+            if (lf) state_ = TrailerStart;
+            break;
+        }
+        case EndLF:
+            if (c != '\n') return -1;
+            state_ = End;
+            ++src;
+            break;
+        case End:
+            break;
+        }
+        if (state_ == End) {
+            // the bytes after the body belong to the next request
+            size_t rest = len - src;
+            if (dst + trailer != src)
+                std::memmove(buf + dst + trailer, buf + src, rest);
+            len = dst;
+            return static_cast<ssize_t>(rest);
+        }
+    }
+    len = dst;
+    return -2;
+}
+
+void ChunkedDecoder::reset() {
+    state_ = Size;
+    chunk_remaining_ = 0;
+    has_digit_ = false;
+    trailers_length_ = 0;
+}
+
+} // namespace webstab
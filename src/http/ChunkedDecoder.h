@@ -0,0 +1,72 @@
+// File:     src/http/ChunkedDecoder.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_CHUNKEDDECODER_H
+#define WEBSTABLE_HTTP_CHUNKEDDECODER_H
+
+// C++
+#include <cstddef>
+
+// Linux
+#include <sys/types.h>
+
+namespace webstab {
+
+// incremental decoder of 'Transfer-Encoding: chunked', which removes the
+// framing in place. the state survives between calls, so every byte is
+// looked at only once however the body is split
+class ChunkedDecoder {
+    enum State {
+        Size, Extension, SizeLF, Data, DataCR, DataLF,
+        TrailerStart, Trailer, EndLF, End
+    };
+
+    State state_ = Size;
+    size_t chunk_remaining_ = 0;
+    bool has_digit_ = false;
+
+    // length of the trailer lines 'Name: value\r\n' received so far
+    size_t trailers_length_ = 0;
+
+public:
+    // decodes 'len' bytes at 'buf'. the data of the chunks is moved to the
+    // front of 'buf' and 'len' is set to its length, the trailer lines are
+    // moved to follow it. returns -2 when the body is not complete yet, -1
+    // on malformed input, otherwise the number of bytes after the body,
+    // moved to follow the trailer lines. once trailer lines arrived, the
+    // next call starts right after them
+    ssize_t decode(char* buf, size_t& len);
+
+    inline size_t trailers_length() const { return trailers_length_; }
+
+    void reset();
+
+}; // class ChunkedDecoder
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_CHUNKEDDECODER_H
@@ -0,0 +1,116 @@
+// File:     src/http/Gzip.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Gzip.h"
+
+// C
+#include <cstdint>
+
+namespace webstab {
+
+namespace {
+
+// windowBits of deflateInit2, 16 selects the gzip wrapper
+constexpr int GzipWindowBits = 15 + 16;
+constexpr int GzipMemLevel = 8;
+
+} // anonymous namespace
+
+bool gzip_compress(const char* data, size_t len, int level,
+        std::string& out) noexcept {
+    // a single deflate() call takes at most 4 GiB
+    if (len > UINT32_MAX) return false;
+    z_stream stream {};
+    if (deflateInit2(&stream, level, Z_DEFLATED, GzipWindowBits,
+            GzipMemLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    bool success = false;
+    try {
+        out.resize(deflateBound(&stream, len));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream.avail_in = static_cast<uInt>(len);
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        stream.avail_out = static_cast<uInt>(out.size());
+        if (deflate(&stream, Z_FINISH) == Z_STREAM_END) {
+            out.resize(stream.total_out);
+            out.shrink_to_fit();
+            success = true;
+        }
+    } catch (...) {
+        // out of memory, not compressed
+    }
+    deflateEnd(&stream);
+    return success;
+}
+
+GzipStream::~GzipStream() {
+    if (level_ != -1) deflateEnd(&stream_);
+}
+
+bool GzipStream::reset(int level) noexcept {
+    if (level_ == level)
+        return deflateReset(&stream_) == Z_OK;
+    if (level_ != -1)
+        deflateEnd(&stream_);
+    stream_ = z_stream {};
+    level_ = -1;
+    if (deflateInit2(&stream_, level, Z_DEFLATED, GzipWindowBits,
+            GzipMemLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    level_ = level;
+    return true;
+}
+
+bool GzipStream::write(const char* data, size_t len, bool finish,
+        std::string& out) noexcept {
+    if (level_ == -1 || len > UINT32_MAX) return false;
+    try {
+        stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream_.avail_in = static_cast<uInt>(len);
+        int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+        int ret = Z_OK;
+        do {
+            // deflateBound is for a whole member, this is an estimate
+            size_t size = out.size();
+            size_t room = len / 2 + 64;
+            out.resize(size + room);
+            stream_.next_out = reinterpret_cast<Bytef*>(&out[size]);
+            stream_.avail_out = static_cast<uInt>(room);
+            ret = deflate(&stream_, flush);
+            out.resize(size + room - stream_.avail_out);
+            if (ret == Z_STREAM_ERROR) return false;
+            // no progress is possible, the member is broken
+            if (finish && ret == Z_BUF_ERROR && stream_.avail_out)
+                return false;
+        } while (stream_.avail_out == 0
+            || (finish && ret != Z_STREAM_END));
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace webstab
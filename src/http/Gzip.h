@@ -0,0 +1,72 @@
+// File:     src/http/Gzip.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_GZIP_H
+#define WEBSTABLE_HTTP_GZIP_H
+
+// C++
+#include <cstddef>
+#include <string>
+
+// zlib
+#include <zlib.h>
+
+namespace webstab {
+
+// compresses 'len' bytes of 'data' into one gzip member at 'level' (1-9),
+// returns false when zlib fails
+bool gzip_compress(const char* data, size_t len, int level,
+    std::string& out) noexcept;
+
+// a deflate stream that writes gzip members piece by piece. the state
+// is allocated once and reset for every member, so one instance per
+// thread serves all the responses compressed on it
+class GzipStream {
+    z_stream stream_ {};
+    int level_ = -1;
+
+public:
+    GzipStream() = default;
+    ~GzipStream();
+
+    // non-copyable
+    GzipStream(const GzipStream&) = delete;
+    GzipStream& operator=(const GzipStream&) = delete;
+
+    // starts a new member at 'level' (1-9)
+    bool reset(int level) noexcept;
+
+    // compresses 'len' bytes of 'data' and appends the output to 'out'.
+    // 'finish' ends the member. returns false when zlib fails
+    bool write(const char* data, size_t len, bool finish,
+        std::string& out) noexcept;
+
+}; // class GzipStream
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_GZIP_H
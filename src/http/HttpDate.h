@@ -1,4 +1,4 @@
-// File:     src/http/HttpResponse.cpp
+// File:     src/http/HttpDate.h
 // Author:   AkashiNeko
 // Project:  WebStable
 // Github:   https://github.com/AkashiNeko/WebStable/
@@ -24,31 +24,25 @@
  * SOFTWARE.
  */
 
-#include "HttpResponse.h"
+#pragma once
+#ifndef WEBSTABLE_HTTP_HTTPDATE_H
+#define WEBSTABLE_HTTP_HTTPDATE_H
 
-namespace webstab {
-
-HttpResponse::HttpResponse(const std::string& version,
-        const std::string& statusCode,
-        const std::string& statusMessage)
-    : version(version),
-    status_code(statusCode),
-    status_message(statusMessage) {}
-
-// to string
-std::string HttpResponse::to_string() const {
+// C++
+#include <ctime>
+#include <string_view>
 
-    if (version.empty() || status_code.empty() || status_message.empty())
-        return "";
+namespace webstab {
 
-    std::string result =
-        version + ' ' + status_code + ' ' + status_message + "\r\n";
+// length of 'Sun, 06 Nov 1994 08:49:37 GMT'
+constexpr size_t HttpDateLength = 29;
 
-    for (const auto& e : headers)
-        result += e.first + ": " + e.second + "\r\n";
+// writes the IMF-fixdate of 'time' and a '\0' to 'buf'
+void format_http_date(std::time_t time, char (&buf)[HttpDateLength + 1]) noexcept;
 
-    result += "\r\n" + body;
-    return result;
-}
+// parses an IMF-fixdate, returns -1 when it is not one
+std::time_t parse_http_date(std::string_view date) noexcept;
 
 } // namespace webstab
+
+#endif // WEBSTABLE_HTTP_HTTPDATE_H
@@ -0,0 +1,305 @@
+// File:     src/http/HttpParser.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HttpParser.h"
+
+// C++
+#include <algorithm>
+
+// SIMD
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace webstab {
+
+namespace {
+
+inline bool is_blank_(char c) {
+    return c == ' ' || c == '\t';
+}
+
+// [begin, end) without leading and trailing blanks
+inline std::string_view trim_(const char* begin, const char* end) {
+    while (begin < end && is_blank_(*begin)) ++begin;
+    while (end > begin && is_blank_(end[-1])) --end;
+    return std::string_view(begin, end - begin);
+}
+
+inline std::string_view trim_(std::string_view s) {
+    return trim_(s.data(), s.data() + s.size());
+}
+
+// end of line, the '\r' of "\r\n" is not a part of the line
+inline const char* line_end_(const char* begin, const char* eol) {
+    return (eol > begin && eol[-1] == '\r') ? eol - 1 : eol;
+}
+
+// token characters, the only ones allowed in a field name
+inline bool is_tchar_(char c) {
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+            || (c >= 'A' && c <= 'Z'))
+        return true;
+    switch (c) {
+    case '!': case '#': case '$': case '%': case '&': case '\'':
+    case '*': case '+': case '-': case '.': case '^': case '_':
+    case '`': case '|': case '~':
+        return true;
+    default:
+        return false;
+    }
+}
+
+inline bool is_token_(std::string_view s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), is_tchar_);
+}
+
+inline char to_lower_(char c) {
+    return (c > 64 && c < 91) ? (c | 0x20) : c;
+}
+
+// 'Connection' is a list of tokens, 'keep-alive, Upgrade'
+bool keep_alive_(std::string_view connection, std::string_view version) {
+    bool keep_alive = version >= "HTTP/1.1";
+    while (!connection.empty()) {
+        size_t comma = connection.find(',');
+        std::string_view token = trim_(connection.data(),
+            connection.data() + std::min(comma, connection.size()));
+        if (iequals(token, "close")) return false;
+        if (iequals(token, "keep-alive")) keep_alive = true;
+        if (comma == std::string_view::npos) break;
+        connection.remove_prefix(comma + 1);
+    }
+    return keep_alive;
+}
+
+// splits the field line at 'p' into 'name' and 'value' and moves 'p' to
+// the next line. 'name' is empty at the blank line or the end, returns
+// false when the line is malformed
+bool next_field_(const char*& p, const char* end,
+        std::string_view& name, std::string_view& value) {
+    name = std::string_view();
+    if (p >= end) return true;
+    const char* eol = find_either(p, end, '\n', '\n');
+    const char* line_end = line_end_(p, eol);
+    if (line_end == p) return true;
+    const char* colon = find_either(p, line_end, ':', ':');
+    if (colon == line_end) return false;
+    // no blank before the colon and no folded line, a name that is
+    // not a token is refused
+    name = std::string_view(p, colon - p);
+    if (!is_token_(name)) return false;
+    value = trim_(colon + 1, line_end);
+    p = eol + 1;
+    return true;
+}
+
+} // anonymous namespace
+
+bool iequals(std::string_view a, std::string_view b) noexcept {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (to_lower_(a[i]) != to_lower_(b[i])) return false;
+    return true;
+}
+
+const char* find_either(const char* p, const char* end,
+        char a, char b) noexcept {
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i wa = _mm_set1_epi8(a), wb = _mm_set1_epi8(b);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, wa), _mm_cmpeq_epi8(v, wb))));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+#endif
+    for (; p < end; ++p)
+        if (*p == a || *p == b) return p;
+    return end;
+}
+
+size_t find_head_end(const char* buf, size_t len, size_t from) noexcept {
+    const char* end = buf + len;
+    const char* p = buf + from;
+    // every line ends with '\n', the head ends with an empty line
+    while ((p = find_either(p, end, '\n', '\n')) != end) {
+        ++p;
+        if (p < end && *p == '\n')
+            return p + 1 - buf;
+        if (end - p >= 2 && p[0] == '\r' && p[1] == '\n')
+            return p + 2 - buf;
+    }
+    return 0;
+}
+
+bool parse_request_head(const char* buf, size_t len,
+        HttpRequest& request) noexcept {
+    // +------------------------------+
+    // | http request message example |
+    // +------------------------------+
+    // | POST / HTTP/1.0\r\n          |
+    // | Accept: */*\r\n              |
+    // | Host: 127.0.0.1\r\n          |
+    // | User-Agent: Mozilla/5.0\r\n  |
+    // | Content-Length: 4\r\n        |
+    // | \r\n                         |
+    // +------------------------------+
+    const char* p = buf;
+    const char* end = buf + len;
+
+    // request line 'METHOD PATH VERSION\r\n'
+    const char* eol = find_either(p, end, '\n', '\n');
+    if (eol == end) return false;
+    const char* line_end = line_end_(p, eol);
+
+    const char* sp = find_either(p, line_end, ' ', ' ');
+    if (sp == p || sp == line_end) return false;
+    request.method = std::string_view(p, sp - p);
+
+    p = sp + 1;
+    sp = find_either(p, line_end, ' ', ' ');
+    if (sp == p || sp == line_end) return false;
+    request.path = std::string_view(p, sp - p);
+
+    request.version = std::string_view(sp + 1, line_end - sp - 1);
+    if (request.version.compare(0, 5, "HTTP/") != 0) return false;
+
+    // headers 'Name: value\r\n', until the empty line
+    request.header_count = 0;
+    if (!parse_header_lines(eol + 1, end - eol - 1, request))
+        return false;
+
+    request.persistent = keep_alive_(
+        request.known[HeaderConnection], request.version);
+    return true;
+}
+
+bool parse_header_lines(const char* buf, size_t len,
+        HttpRequest& request) noexcept {
+    const char* end = buf + len;
+    std::string_view name, value;
+    for (const char* p = buf;;) {
+        if (!next_field_(p, end, name, value)) return false;
+        if (name.empty()) break;
+
+        // a known header goes to its slot, the first one wins
+        KnownHeader id = lookup_header(name);
+        if (id != HeaderUnknown) {
+            std::string_view& slot = request.known[id];
+            if (slot.data() == nullptr) {
+                slot = value;
+            } else if (id == HeaderContentLength
+                    || id == HeaderTransferEncoding) {
+                // ambiguous body length, refused against smuggling
+                return false;
+            }
+            continue;
+        }
+        if (request.header_count == HttpRequest::MaxHeaders) return false;
+        request.headers[request.header_count++] = { name, value };
+    }
+    return true;
+}
+
+bool check_trailer_lines(const char* buf, size_t len) noexcept {
+    const char* end = buf + len;
+    std::string_view name, value;
+    for (const char* p = buf;;) {
+        if (!next_field_(p, end, name, value)) return false;
+        if (name.empty()) return true;
+        switch (lookup_header(name)) {
+        case HeaderAcceptEncoding:
+        case HeaderUserAgent:
+        case HeaderReferer:
+        case HeaderAccept:
+        case HeaderUnknown:
+            break;
+        default:
+            // framing, routing, conditionals and the like are only
+            // taken from the head
+            return false;
+        }
+    }
+}
+
+int check_transfer_encoding(std::string_view transfer_encoding) noexcept {
+    size_t codings = 0, chunked = 0;
+    bool last_chunked = false;
+    while (!transfer_encoding.empty()) {
+        size_t comma = transfer_encoding.find(',');
+        std::string_view item = trim_(transfer_encoding.substr(0, comma));
+        transfer_encoding = comma == std::string_view::npos
+            ? std::string_view() : transfer_encoding.substr(comma + 1);
+        // empty list elements are allowed and ignored
+        if (item.empty()) continue;
+        ++codings;
+        last_chunked = iequals(item, "chunked");
+        if (last_chunked) ++chunked;
+    }
+    if (!last_chunked || chunked > 1) return 400;
+    return codings > 1 ? 501 : 0;
+}
+
+bool accepts_encoding(std::string_view accept_encoding,
+        std::string_view coding) noexcept {
+    // -1 when not listed, otherwise whether the qvalue is nonzero
+    int by_name = -1, by_wildcard = -1;
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos
+            ? std::string_view() : accept_encoding.substr(comma + 1);
+
+        // 'gzip;q=0.5'
+        size_t semicolon = item.find(';');
+        std::string_view name = trim_(item.substr(0, semicolon));
+        bool allowed = true;
+        if (semicolon != std::string_view::npos) {
+            std::string_view param = trim_(item.substr(semicolon + 1));
+            if (param.size() >= 2 && to_lower_(param[0]) == 'q'
+                    && param[1] == '=') {
+                param.remove_prefix(2);
+                allowed = param.find_first_not_of("0.")
+                    != std::string_view::npos;
+            }
+        }
+        if (iequals(name, coding)) by_name = allowed;
+        else if (name == "*") by_wildcard = allowed;
+    }
+    return by_name != -1 ? by_name : by_wildcard == 1;
+}
+
+} // namespace webstab
@@ -0,0 +1,82 @@
+// File:     src/http/HttpParser.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_HTTPPARSER_H
+#define WEBSTABLE_HTTP_HTTPPARSER_H
+
+// C++
+#include <cstddef>
+
+// WebStable
+#include "http/HttpRequest.h"
+
+namespace webstab {
+
+// case-insensitive comparison of ascii strings
+bool iequals(std::string_view a, std::string_view b) noexcept;
+
+// returns the first byte in [begin, end) that equals 'a' or 'b',
+// or 'end' if there is none. scans 32/16 bytes at a time on AVX2/SSE2
+const char* find_either(const char* begin, const char* end,
+    char a, char b) noexcept;
+
+// searches the blank line that terminates a request head, starting at
+// 'from'. returns the length of the head (blank line included), or 0
+// when the head is not complete yet
+size_t find_head_end(const char* buf, size_t len, size_t from = 0) noexcept;
+
+// parses a complete request head of 'len' bytes. the fields of 'request'
+// are views into 'buf', which must outlive them. returns false when the
+// head is malformed or has more than HttpRequest::MaxHeaders headers
+bool parse_request_head(const char* buf, size_t len,
+    HttpRequest& request) noexcept;
+
+// parses 'Name: value' lines of 'len' bytes, up to an empty line, and
+// appends them to the headers of 'request'. returns false when a line is
+// malformed or there are too many headers
+bool parse_header_lines(const char* buf, size_t len,
+    HttpRequest& request) noexcept;
+
+// checks the trailer lines of a chunked body, which are not added to the
+// request. returns false when a line is malformed or names a field that
+// must come in the head, such as Host, Content-Length or Range
+bool check_trailer_lines(const char* buf, size_t len) noexcept;
+
+// checks the Transfer-Encoding value of a request. returns 0 when the
+// body is chunked, otherwise the status to refuse the request with: 400
+// when chunked is not the last coding once, the body length is unknown
+// then, and 501 for other codings before it, which are not decoded
+int check_transfer_encoding(std::string_view transfer_encoding) noexcept;
+
+// whether an Accept-Encoding value allows 'coding', either by name or by
+// '*', with a nonzero qvalue
+bool accepts_encoding(std::string_view accept_encoding,
+    std::string_view coding) noexcept;
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_HTTPPARSER_H
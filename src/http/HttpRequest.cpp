@@ -26,49 +26,41 @@
 
 #include "HttpRequest.h"
 
-namespace webstab {
-
-HttpRequest::HttpRequest() {}
+// WebStable
+#include "http/HttpParser.h"
 
-HttpRequest::HttpRequest(const std::string& method,
-            const Url& url,
-            const std::string& version)
-        : method(method),
-        path(url.authority_after()),
-        version(version),
-        host(url.host),
-        port(url.port),
-        use_ssl(url.scheme == "https") {}
+namespace webstab {
 
 std::string HttpRequest::to_string() const {
-    std::string request = method + ' ' + path + ' ' + version + "\r\n";
-
-    for (const auto& e : headers)
-        request += e.first + ": " + e.second + "\r\n";
+    std::string request;
+    request.append(method).append(1, ' ').append(path)
+        .append(1, ' ').append(version).append("\r\n");
 
-    request += "\r\n" + body;
-    return request;
-}
+    for (size_t i = 0; i < KnownHeaderCount; ++i) {
+        if (known[i].data() == nullptr) continue;
+        request.append(known_header_name(static_cast<KnownHeader>(i)))
+            .append(": ").append(known[i]).append("\r\n");
+    }
 
-std::string HttpRequest::lower_header(const std::string& key) const {
-    auto it = headers.find(key);
-    if (it == headers.end()) return "";
-    std::string result(it->second);
-    for (char& c : result)
-        if (c > 64 && c < 91) c |= 0x20;
-    return result;
-}
+    for (size_t i = 0; i < header_count; ++i) {
+        request.append(headers[i].name).append(": ")
+            .append(headers[i].value).append("\r\n");
+    }
 
-std::string HttpRequest::relative_path() const {
-    if (path.size() < 2) return "";
-    return path.substr(1);
+    request.append("\r\n");
+    body.read([&request](std::string_view chunk) {
+        request.append(chunk);
+        return true;
+    });
+    return request;
 }
 
-bool HttpRequest::keep_alive() const {
-    std::string&& connection = lower_header("Connection");
-    if (connection == "keep-alive") return true;
-    else if (connection == "close") return false;
-    return version >= "HTTP/1.1";
+std::string_view HttpRequest::header(std::string_view name) const {
+    KnownHeader id = lookup_header(name);
+    if (id != HeaderUnknown) return known[id];
+    for (size_t i = 0; i < header_count; ++i)
+        if (iequals(headers[i].name, name)) return headers[i].value;
+    return std::string_view();
 }
 
 } // namespace webstab
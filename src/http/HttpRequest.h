@@ -29,38 +29,54 @@
 #define WEBSTABLE_HTTP_HTTPREQUEST_H
 
 // C++
-#include <unordered_map>
 #include <string>
-
-// nanonet
-#include "nanonet.h"
+#include <string_view>
 
 // WebStable
-#include "http/Url.h"
+#include "http/KnownHeader.h"
+#include "http/RequestBody.h"
 
 namespace webstab {
 
+// a header of the request, views into the receive buffer
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
 struct HttpRequest {
 public:
-    std::string method;
-    std::string path;
-    std::string version;
-    std::unordered_map<std::string, std::string> headers;
-    std::string host;
-    nano::Port port;
-    std::string body;
-    bool use_ssl = false;
+    // other headers beyond this number make the request malformed
+    static constexpr size_t MaxHeaders = 32;
+
+    std::string_view method;
+    std::string_view path;
+    std::string_view version;
+
+    // values of the known headers, by KnownHeader
+    std::string_view known[KnownHeaderCount];
+
+    // the other headers, in order of arrival
+    HttpHeader headers[MaxHeaders];
+    size_t header_count = 0;
+
+    // set from 'Connection' and the version by the parser
+    bool persistent = false;
+
+    RequestBody body;
 
 public:
 
-    HttpRequest();
-    HttpRequest(const std::string& method,
-        const Url& url, const std::string& version);
+    HttpRequest() = default;
 
     std::string to_string() const;
-    std::string lower_header(const std::string& key) const;
-    std::string relative_path() const;
-    bool keep_alive() const;
+    std::string_view header(std::string_view name) const;
+
+    inline std::string_view header(KnownHeader id) const {
+        return known[id];
+    }
+
+    inline bool keep_alive() const { return persistent; }
 
 }; // struct HttpRequest
 
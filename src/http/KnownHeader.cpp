@@ -0,0 +1,102 @@
+// File:     src/http/KnownHeader.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "KnownHeader.h"
+
+namespace webstab {
+
+namespace {
+
+constexpr std::string_view HeaderNames[KnownHeaderCount] = {
+    "Host",
+    "Connection",
+    "Content-Length",
+    "Transfer-Encoding",
+    "Accept-Encoding",
+    "If-None-Match",
+    "If-Modified-Since",
+    "Range",
+    "If-Range",
+    "Content-Type",
+    "User-Agent",
+    "Referer",
+    "Accept",
+    "Cookie",
+    "Expect",
+    "Cache-Control",
+    "Authorization",
+    "Upgrade",
+};
+
+constexpr size_t HashSize = 32;
+
+constexpr char to_lower_(char c) {
+    return (c > 64 && c < 91) ? (c | 0x20) : c;
+}
+
+// length, first and last letter are distinct enough for the names above,
+// the table below fails to compile if two of them collide
+constexpr size_t hash_(std::string_view name) {
+    return (name.size() * 2 + to_lower_(name.front())
+        + to_lower_(name.back()) * 27) % HashSize;
+}
+
+struct HashTable {
+    KnownHeader slots[HashSize] {};
+    bool perfect = true;
+
+    constexpr HashTable() {
+        for (size_t i = 0; i < HashSize; ++i)
+            slots[i] = HeaderUnknown;
+        for (size_t i = 0; i < KnownHeaderCount; ++i) {
+            size_t h = hash_(HeaderNames[i]);
+            if (slots[h] != HeaderUnknown) perfect = false;
+            slots[h] = static_cast<KnownHeader>(i);
+        }
+    }
+};
+
+constexpr HashTable Table;
+static_assert(Table.perfect, "known header names collide in the hash");
+
+} // anonymous namespace
+
+std::string_view known_header_name(KnownHeader id) noexcept {
+    return id < KnownHeaderCount ? HeaderNames[id] : std::string_view();
+}
+
+KnownHeader lookup_header(std::string_view name) noexcept {
+    if (name.empty()) return HeaderUnknown;
+    KnownHeader id = Table.slots[hash_(name)];
+    if (id == HeaderUnknown) return HeaderUnknown;
+    std::string_view known = HeaderNames[id];
+    if (known.size() != name.size()) return HeaderUnknown;
+    for (size_t i = 0; i < name.size(); ++i)
+        if (to_lower_(name[i]) != to_lower_(known[i])) return HeaderUnknown;
+    return id;
+}
+
+} // namespace webstab
@@ -0,0 +1,69 @@
+// File:     src/http/KnownHeader.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_KNOWNHEADER_H
+#define WEBSTABLE_HTTP_KNOWNHEADER_H
+
+// C++
+#include <string_view>
+
+namespace webstab {
+
+// headers recognised while parsing, each has a fixed slot in HttpRequest
+enum KnownHeader : unsigned char {
+    HeaderHost,
+    HeaderConnection,
+    HeaderContentLength,
+    HeaderTransferEncoding,
+    HeaderAcceptEncoding,
+    HeaderIfNoneMatch,
+    HeaderIfModifiedSince,
+    HeaderRange,
+    HeaderIfRange,
+    HeaderContentType,
+    HeaderUserAgent,
+    HeaderReferer,
+    HeaderAccept,
+    HeaderCookie,
+    HeaderExpect,
+    HeaderCacheControl,
+    HeaderAuthorization,
+    HeaderUpgrade,
+    KnownHeaderCount,
+    HeaderUnknown = KnownHeaderCount
+};
+
+// canonical name of a known header
+std::string_view known_header_name(KnownHeader id) noexcept;
+
+// the known header named 'name' in any case, or HeaderUnknown. costs one
+// perfect hash probe and one comparison
+KnownHeader lookup_header(std::string_view name) noexcept;
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_KNOWNHEADER_H
@@ -0,0 +1,101 @@
+// File:     src/http/PathNormalizer.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PathNormalizer.h"
+
+namespace webstab {
+
+namespace {
+
+inline int hex_value_(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// percent-decodes 'in' into 'out'
+bool decode_(std::string_view in, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i] != '%') {
+            out.push_back(in[i]);
+            continue;
+        }
+        if (i + 2 >= in.size()) return false;
+        int high = hex_value_(in[i + 1]), low = hex_value_(in[i + 2]);
+        if (high < 0 || low < 0 || (high | low) == 0) return false;
+        out.push_back(static_cast<char>(high << 4 | low));
+        i += 2;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool normalize_path(std::string_view target, std::string& path) {
+    // absolute-form 'http://host/path' is reduced to its path
+    if (!target.empty() && target.front() != '/') {
+        size_t scheme = target.find("://");
+        if (scheme == std::string_view::npos) return false;
+        size_t slash = target.find('/', scheme + 3);
+        target = slash == std::string_view::npos
+            ? std::string_view("/") : target.substr(slash);
+    }
+    if (target.empty()) return false;
+    target = target.substr(0, target.find_first_of("?#"));
+
+    // decoded first, so that '%2e%2e' is resolved like '..'
+    thread_local std::string decoded;
+    if (!decode_(target, decoded)) return false;
+
+    path.clear();
+    path.push_back('/');
+    std::string_view rest = decoded;
+    bool directory = false;
+    while (!rest.empty()) {
+        size_t slash = rest.find('/');
+        std::string_view segment = rest.substr(0, slash);
+        rest = slash == std::string_view::npos
+            ? std::string_view() : rest.substr(slash + 1);
+        directory = true;
+        if (segment.empty() || segment == ".") continue;
+        if (segment == "..") {
+            // above the root
+            if (path.size() == 1) return false;
+            path.pop_back();
+            path.resize(path.rfind('/') + 1);
+            continue;
+        }
+        path.append(segment).push_back('/');
+        directory = slash != std::string_view::npos;
+    }
+    // '/a/b/' keeps its slash, '/a/b' does not
+    if (!directory && path.size() > 1) path.pop_back();
+    return true;
+}
+
+} // namespace webstab
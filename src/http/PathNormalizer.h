@@ -1,4 +1,4 @@
-// File:     src/http/HttpResponse.h
+// File:     src/http/PathNormalizer.h
 // Author:   AkashiNeko
 // Project:  WebStable
 // Github:   https://github.com/AkashiNeko/WebStable/
@@ -25,38 +25,22 @@
  */
 
 #pragma once
-#ifndef WEBSTABLE_HTTP_HTTPRESPONSE_H
-#define WEBSTABLE_HTTP_HTTPRESPONSE_H
+#ifndef WEBSTABLE_HTTP_PATHNORMALIZER_H
+#define WEBSTABLE_HTTP_PATHNORMALIZER_H
 
 // C++
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace webstab {
 
-struct HttpResponse {
-public:
-    std::string version;
-    std::string status_code;
-    std::string status_message;
-    std::unordered_map<std::string, std::string> headers;
-    std::string body;
-
-public:
-
-    HttpResponse(const std::string& version = "HTTP/1.1",
-                const std::string& status_code = "200",
-                const std::string& status_message = "OK");
-
-    inline void set_header(const std::string& key, const std::string& value) {
-        headers[key] = value;
-    }
-
-    // to string
-    std::string to_string() const;
-
-}; // struct HttpResponse
+// the path of a request target as a file path below a root:
+// '/a/./b/../c%20d?v=1#top' is '/a/c d'. the query and the fragment are
+// dropped, escapes are decoded before the segments are resolved, and
+// empty and '.' segments are removed. returns false when the target is
+// not a path, has a bad or NUL escape, or climbs above the root
+bool normalize_path(std::string_view target, std::string& path);
 
 } // namespace webstab
 
-#endif // WEBSTABLE_HTTP_HTTPRESPONSE_H
+#endif // WEBSTABLE_HTTP_PATHNORMALIZER_H
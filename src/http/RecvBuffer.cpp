@@ -0,0 +1,77 @@
+// File:     src/http/RecvBuffer.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RecvBuffer.h"
+
+// C
+#include <cstring>
+
+// C++
+#include <algorithm>
+
+// WebStable
+#include "core/BufferPool.h"
+
+namespace webstab {
+
+RecvBuffer::~RecvBuffer() {
+    BufferPool::release(data_, capacity_);
+}
+
+char* RecvBuffer::prepare(size_t n) {
+    if (capacity_ - size_ < n) {
+        // at least doubles, bytes are never rescanned after moving
+        size_t capacity;
+        char* data = BufferPool::acquire(
+            std::max(size_ + n, capacity_ * 2), capacity);
+        if (size_ != 0) std::memcpy(data, data_, size_);
+        BufferPool::release(data_, capacity_);
+        data_ = data;
+        capacity_ = capacity;
+    }
+    return data_ + size_;
+}
+
+void RecvBuffer::append(const char* data, size_t n) {
+    std::memcpy(prepare(n), data, n);
+    size_ += n;
+}
+
+void RecvBuffer::consume(size_t n) noexcept {
+    erase(0, n);
+}
+
+void RecvBuffer::erase(size_t pos, size_t n) noexcept {
+    if (pos >= size_) return;
+    if (n >= size_ - pos) {
+        size_ = pos;
+    } else {
+        std::memmove(data_ + pos, data_ + pos + n, size_ - pos - n);
+        size_ -= n;
+    }
+}
+
+} // namespace webstab
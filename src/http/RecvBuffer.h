@@ -0,0 +1,75 @@
+// File:     src/http/RecvBuffer.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_RECVBUFFER_H
+#define WEBSTABLE_HTTP_RECVBUFFER_H
+
+// C++
+#include <cstddef>
+
+namespace webstab {
+
+// growable byte buffer of a connection, recv() writes into it in place.
+// the memory comes from the BufferPool and goes back to it
+class RecvBuffer {
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+public:
+    RecvBuffer() = default;
+    ~RecvBuffer();
+
+    // non-copyable
+    RecvBuffer(const RecvBuffer&) = delete;
+    RecvBuffer& operator=(const RecvBuffer&) = delete;
+
+    inline char* data() noexcept { return data_; }
+    inline const char* data() const noexcept { return data_; }
+    inline size_t size() const noexcept { return size_; }
+    inline bool empty() const noexcept { return size_ == 0; }
+
+    // makes room for at least 'n' bytes after the data, returns the start
+    // of it. the data may move, pointers into the buffer must be rebased
+    char* prepare(size_t n);
+
+    // 'n' bytes were written into the room returned by prepare()
+    inline void commit(size_t n) noexcept { size_ += n; }
+
+    void append(const char* data, size_t n);
+
+    // drops the first 'n' bytes
+    void consume(size_t n) noexcept;
+
+    // drops 'n' bytes from 'pos', the bytes before 'pos' do not move
+    void erase(size_t pos, size_t n) noexcept;
+
+}; // class RecvBuffer
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_RECVBUFFER_H
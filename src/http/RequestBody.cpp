@@ -0,0 +1,153 @@
+// File:     src/http/RequestBody.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RequestBody.h"
+
+// C
+#include <cerrno>
+#include <cstdlib>
+
+// C++
+#include <utility>
+
+// Linux
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace webstab {
+
+namespace {
+
+// size of the pieces read from the temporary file
+constexpr size_t ReadChunkLength = 65536;
+
+int open_temp_file_(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd != -1 || (errno != EOPNOTSUPP && errno != EISDIR))
+        return fd;
+    // the file system has no O_TMPFILE, unlink a named one
+    std::string path = dir + "/webstable.XXXXXX";
+    fd = ::mkostemp(path.data(), O_CLOEXEC);
+    if (fd != -1) ::unlink(path.c_str());
+    return fd;
+}
+
+inline void close_fd_(int& fd) noexcept {
+    if (fd != -1) ::close(fd);
+    fd = -1;
+}
+
+} // anonymous namespace
+
+RequestBody::~RequestBody() {
+    clear();
+}
+
+RequestBody::RequestBody(RequestBody&& other) noexcept {
+    *this = std::move(other);
+}
+
+RequestBody& RequestBody::operator=(RequestBody&& other) noexcept {
+    if (this != &other) {
+        clear();
+        std::swap(memory_, other.memory_);
+        std::swap(fd_, other.fd_);
+        std::swap(pipe_, other.pipe_);
+        std::swap(size_, other.size_);
+    }
+    return *this;
+}
+
+bool RequestBody::spill(const std::string& dir) {
+    if (fd_ != -1) return true;
+    fd_ = open_temp_file_(dir);
+    if (fd_ == -1) return false;
+    std::string_view memory = memory_;
+    memory_ = std::string_view();
+    size_ = 0;
+    return write(memory.data(), memory.size());
+}
+
+bool RequestBody::write(const char* data, size_t len) {
+    while (len) {
+        ssize_t ret = ::write(fd_, data, len);
+        if (ret == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += ret;
+        len -= ret;
+        size_ += ret;
+    }
+    return true;
+}
+
+ssize_t RequestBody::splice_from(int sock, size_t len) {
+    if (pipe_[0] == -1 && ::pipe2(pipe_, O_CLOEXEC) == -1)
+        return -1;
+    ssize_t in = ::splice(sock, nullptr, pipe_[1], nullptr,
+        len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (in <= 0) return in;
+    // drain the pipe into the file entirely
+    for (ssize_t out = in; out;) {
+        ssize_t ret = ::splice(pipe_[0], nullptr, fd_, nullptr,
+            out, SPLICE_F_MOVE);
+        if (ret <= 0) {
+            if (ret == -1 && errno == EINTR) continue;
+            return -1;
+        }
+        out -= ret;
+    }
+    size_ += in;
+    return in;
+}
+
+bool RequestBody::read(
+        const std::function<bool(std::string_view)>& consume) const {
+    if (fd_ == -1)
+        return memory_.empty() || consume(memory_);
+    char buf[ReadChunkLength];
+    for (off_t offset = 0; offset < static_cast<off_t>(size_);) {
+        ssize_t ret = ::pread(fd_, buf, sizeof(buf), offset);
+        if (ret <= 0) {
+            if (ret == -1 && errno == EINTR) continue;
+            return false;
+        }
+        if (!consume(std::string_view(buf, ret))) return false;
+        offset += ret;
+    }
+    return true;
+}
+
+void RequestBody::clear() noexcept {
+    close_fd_(fd_);
+    close_fd_(pipe_[0]);
+    close_fd_(pipe_[1]);
+    memory_ = std::string_view();
+    size_ = 0;
+}
+
+} // namespace webstab
@@ -0,0 +1,96 @@
+// File:     src/http/RequestBody.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_REQUESTBODY_H
+#define WEBSTABLE_HTTP_REQUESTBODY_H
+
+// C++
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Linux
+#include <sys/types.h>
+
+namespace webstab {
+
+// how the body of a request may be received
+struct BodyPolicy {
+    // larger bodies are answered with 413, 0 is unlimited
+    size_t max_size = 0;
+    // larger bodies are spilled to a temporary file
+    size_t buffer_size = 16384;
+    // directory of the temporary files
+    std::string temp_path = "/tmp";
+};
+
+// body of a request, either a view into memory or an unnamed temporary
+// file. handlers consume it chunk by chunk with read()
+class RequestBody {
+    std::string_view memory_;
+    int fd_ = -1;
+    int pipe_[2] = {-1, -1};
+    size_t size_ = 0;
+
+public:
+    RequestBody() = default;
+    ~RequestBody();
+
+    // non-copyable, movable
+    RequestBody(const RequestBody&) = delete;
+    RequestBody& operator=(const RequestBody&) = delete;
+    RequestBody(RequestBody&& other) noexcept;
+    RequestBody& operator=(RequestBody&& other) noexcept;
+
+    // the body is kept in memory, 'data' must outlive it
+    inline void assign(std::string_view data) noexcept {
+        memory_ = data;
+        size_ = data.size();
+    }
+
+    // moves the body to a temporary file in 'dir'
+    bool spill(const std::string& dir);
+    bool write(const char* data, size_t len);
+
+    // moves up to 'len' bytes from 'sock' into the temporary file through
+    // a pipe, without copying them to user space. returns as recv()
+    ssize_t splice_from(int sock, size_t len);
+
+    inline size_t size() const noexcept { return size_; }
+    inline bool empty() const noexcept { return size_ == 0; }
+    inline bool spilled() const noexcept { return fd_ != -1; }
+
+    // hands the body to 'consume' chunk by chunk until it returns false
+    bool read(const std::function<bool(std::string_view)>& consume) const;
+
+    void clear() noexcept;
+
+}; // class RequestBody
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_REQUESTBODY_H
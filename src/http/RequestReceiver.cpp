@@ -26,194 +26,229 @@
 
 #include "RequestReceiver.h"
 
+// C
+#include <cstring>
+
+// C++
+#include <charconv>
+
+// WebStable
+#include "http/HttpParser.h"
+
 namespace webstab {
 
 namespace {
 
-// converts hex text to digit, on error, -1 is returned
-size_t hex_str_to_dec_(const std::string& hexStr) {
-    try {
-        return static_cast<size_t>(std::stol(hexStr, nullptr, 16));
-    } catch (const std::exception& e) {
-        return std::string::npos;
-    }
-}
+// heads larger than this are refused with 431
+constexpr size_t MaxHeadLength = 65536;
 
-
-std::string capitalize_first_letter_(std::string&& str) {
-    bool upper = true;
-    for (char& c : str) {
-        if (c == '-') {
-            upper = true;
-        } else if (upper) {
-            c &= ~32;
-            upper = false;
-        } else {
-            c |= 32;
-        }
-    }
-    return str;
+inline std::string_view shift_(std::string_view view, ptrdiff_t offset) {
+    if (view.data() == nullptr) return view;
+    return std::string_view(view.data() + offset, view.size());
 }
 
 } // anonymous namespace
 
-bool RequestReceiver::fill_head_(HttpRequest& request, const char* msg) {
-    head_cache_ += msg;
-    body_begin_pos_ = head_cache_.find("\r\n\r\n", body_begin_pos_cache_);
-    // +------------------------------+
-    // | http request message example |
-    // +------------------------------+
-    // | POST / HTTP/1.0\r\n          |
-    // | Accept: */*\r\n              |
-    // | Host: 127.0.0.1\r\n          |
-    // | User-Agent: Mozilla/5.0\r\n  |
-    // | Content-Length: 4\r\n        |
-    // | \r\n                         |
-    // | text                         |
-    // +------------------------------+
-    // if header received in its entirety
-    if (body_begin_pos_ != std::string::npos) {
-
-        // set pos of body start
-        body_begin_pos_ += 4;
-
-        // separate the head (line, headders)
-        body_cache_ += head_cache_.substr(body_begin_pos_);
-        head_cache_.resize(body_begin_pos_ - 2);
-
-        // get line 'METHOD PATH VERSION\r\n'
-        size_t pos = head_cache_.find("\r\n");
-
-        // get METHOD: GET/POST/PUT...
-        size_t methodEnd = head_cache_.find(' ', 0);
-        request.method = head_cache_.substr(0, methodEnd);
-
-        // get PATH: /...
-        size_t pathEnd = head_cache_.find(' ', methodEnd + 1);
-        request.path = head_cache_.substr(methodEnd + 1, pathEnd - methodEnd - 1);
-        
-
-        // get VERSION: HTTP/1.0, HTTP/1.1...
-        request.version = head_cache_.substr(pathEnd + 1, pos - pathEnd - 1);
-
-        // next line
-        pos += 2;
-
-        // get headers
-        while (pos < head_cache_.size()) {
-            size_t beginLine = pos;
-            size_t endLine = head_cache_.find("\r\n", beginLine);
-            size_t colon = head_cache_.find(": ", beginLine);
-            if (colon > endLine) continue;
-            request.headers.insert({
-                capitalize_first_letter_(
-                    head_cache_.substr(beginLine, colon - beginLine)),
-                head_cache_.substr(colon + 2, endLine - colon - 2)
-            });
-            pos = endLine + 2;
-        }
-        // set args
-        auto it = request.headers.find("Content-Length");
-        if (it != request.headers.end()) {
-            header_content_length_ = std::stoi(it->second);
-        } else {
-            it = request.headers.find("Transfer-Encoding");
-            if (it != request.headers.end() && it->second == "chunked")
-                chunked_transfer_encoding_ = true;
-        }
-        // OK
-        this->head_done_ = true;
-        // fill body
-        bool ret = append_body_(body_cache_.c_str());
-        body_cache_.clear();
-        if (request.method == "GET")
-            return is_ok_ = true;
-        return ret;
+bool RequestReceiver::fill_head_(HttpRequest& request) {
+    const char* buf = buffer_.data();
+    size_t head_length = find_head_end(buf, buffer_.size(), head_scan_pos_);
+
+    if (head_length == 0) {
+        if (buffer_.size() > MaxHeadLength)
+            return fail_(431);
+        // the blank line is not received yet, the next search starts
+        // from the last 3 bytes, which may be a part of it
+        head_scan_pos_ = buffer_.size() > 3 ? buffer_.size() - 3 : 0;
+        return false;
     }
-    // cannot found '\r\n\r\n', set find start pos to size - 4
-    body_begin_pos_cache_ = head_cache_.size() - 4;
-    if (body_begin_pos_cache_ < 0)
-        body_begin_pos_cache_ = 0;
-    return false;
+
+    // header received in its entirety
+    if (!parse_request_head(buf, head_length, request))
+        return fail_(400);
+
+    // set args
+    std::string_view value = request.header(HeaderContentLength);
+    std::string_view encoding = request.header(HeaderTransferEncoding);
+    if (encoding.data() != nullptr) {
+        // framed differently by a proxy that reads the other header, the
+        // request would be smuggled past it
+        if (value.data() != nullptr)
+            return fail_(400);
+        if (int status = check_transfer_encoding(encoding))
+            return fail_(status);
+        chunked_transfer_encoding_ = true;
+    } else if (!value.empty()) {
+        auto [end, ec] = std::from_chars(value.data(),
+            value.data() + value.size(), header_content_length_);
+        if (ec != std::errc() || end != value.data() + value.size())
+            return fail_(400);
+        // refuse a too large body before receiving it
+        if (policy_.max_size && header_content_length_ > policy_.max_size)
+            return fail_(413);
+        if (header_content_length_ > policy_.buffer_size
+                && !request.body.spill(policy_.temp_path))
+            return fail_(500);
+        body_remaining_ = header_content_length_;
+    } else {
+        // neither of them, there is no body
+        header_content_length_ = 0;
+    }
+
+    // OK
+    this->head_done_ = true;
+    body_begin_pos_ = decoded_end_pos_ = head_length;
+
+    // fill body with the rest of the received bytes
+    return append_body_();
 }
 
 // append chunks when 'Transfer-Encoding' is 'chunked'
 
-bool RequestReceiver::append_chunk_(const char* msg) {
-    chunk_cache_ += msg;
-    size_t length = chunk_cache_.size();
-    while (chunk_base_ < length) {
-        if (chunk_last_ == 0) {
-            if ((chunk_pos_ = chunk_cache_.find("\r\n", chunk_base_)) != std::string::npos) {
-                size_t chunkLength = hex_str_to_dec_(
-                    chunk_cache_.substr(chunk_base_, chunk_pos_ - chunk_base_));
-                if (chunkLength == 0) {
-                    chunk_cache_.clear();
-                    return is_ok_ = true;
-                }
-                chunk_last_ = chunkLength;
-                chunk_base_ = chunk_pos_ += 2;
-                if (chunk_base_ >= length)
-                    return false;
-            } else {
-                return false;
-            }
-        } else {
-            size_t append_length = length - chunk_base_;
-            if (append_length <= chunk_last_) {
-                httpmsg_.body += chunk_cache_.substr(chunk_base_, append_length);
-                chunk_last_ -= append_length;
-                chunk_base_ = chunk_pos_ = length;
-                return false;
-            } else {
-                httpmsg_.body += chunk_cache_.substr(chunk_base_, chunk_last_);
-                chunk_base_ += chunk_last_ + 2;
-                chunk_last_ = 0;
-            }
-            // clear cache
-            if (chunk_base_ == chunk_cache_.size()) {
-                chunk_cache_.clear();
-                chunk_base_ = 0;
-            }
-        }
+bool RequestReceiver::append_chunk_() {
+    // decode the received bytes in place, following the decoded data and
+    // the trailer lines received before
+    size_t from = decoded_end_pos_ + decoder_.trailers_length();
+    size_t length = buffer_.size() - from;
+    ssize_t rest = decoder_.decode(buffer_.data() + from, length);
+    if (rest == -1)
+        return fail_(400);
+    decoded_end_pos_ += length;
+    size_t trailers_end = decoded_end_pos_ + decoder_.trailers_length();
+
+    // drop the framing, keep the trailer lines and the bytes of the next
+    // request if any
+    buffer_.erase(trailers_end + (rest > 0 ? rest : 0), buffer_.size());
+
+    RequestBody& body = httpmsg_.body;
+    size_t decoded = decoded_end_pos_ - body_begin_pos_;
+    if (policy_.max_size && body.size() + decoded > policy_.max_size)
+        return fail_(413);
+    if (body.spilled() || decoded > policy_.buffer_size) {
+        // too large to be kept in memory
+        if (!body.spill(policy_.temp_path)
+                || !body.write(buffer_.data() + body_begin_pos_, decoded))
+            return fail_(500);
+        buffer_.erase(body_begin_pos_, decoded);
+        decoded_end_pos_ = body_begin_pos_;
     }
-    return false;
+    if (rest < 0)
+        return false;
+
+    // last chunk and trailers received
+    request_end_pos_ = decoded_end_pos_ + decoder_.trailers_length();
+    if (!body.spilled()) {
+        body.assign(std::string_view(buffer_.data() + body_begin_pos_,
+            decoded_end_pos_ - body_begin_pos_));
+    }
+    if (!check_trailer_lines(buffer_.data() + decoded_end_pos_,
+            decoder_.trailers_length()))
+        return fail_(400);
+    return is_ok_ = true;
 }
 
-
-bool RequestReceiver::append_body_(const char* msg) {
+bool RequestReceiver::append_body_() {
     // when 'Transfer-Encoding' is 'chunked'
     if (chunked_transfer_encoding_)
-        return append_chunk_(msg);
-    // append to body
-    httpmsg_.body += msg;
-    // when 'Content-Length' is set
-    if (header_content_length_ != std::string::npos) {
-        if (httpmsg_.body.size() >= header_content_length_) {
-            // receive done. truncate
-            httpmsg_.body.resize(header_content_length_);
-            return is_ok_ = true;
-        } else {
-            // continue
+        return append_chunk_();
+    size_t received = buffer_.size() - body_begin_pos_;
+    RequestBody& body = httpmsg_.body;
+    if (body.spilled()) {
+        // move the received part of the body to the temporary file
+        size_t length = std::min(received, body_remaining_);
+        if (!body.write(buffer_.data() + body_begin_pos_, length))
+            return fail_(500);
+        body_remaining_ -= length;
+        if (body_remaining_) {
+            buffer_.erase(body_begin_pos_, length);
             return false;
         }
+        request_end_pos_ = body_begin_pos_ + length;
+        return is_ok_ = true;
+    }
+    // when 'Content-Length' is set
+    if (received < header_content_length_)
+        return false;
+    // receive done, the body is a view into the buffer
+    body_remaining_ = 0;
+    request_end_pos_ = body_begin_pos_ + header_content_length_;
+    body.assign(std::string_view(
+        buffer_.data() + body_begin_pos_, header_content_length_));
+    return is_ok_ = true;
+}
+
+bool RequestReceiver::fail_(int status) {
+    error_ = status;
+    return is_ok_ = true;
+}
+
+void RequestReceiver::rebase_(const char* old_base) {
+    ptrdiff_t offset = buffer_.data() - old_base;
+    httpmsg_.method = shift_(httpmsg_.method, offset);
+    httpmsg_.path = shift_(httpmsg_.path, offset);
+    httpmsg_.version = shift_(httpmsg_.version, offset);
+    for (std::string_view& value : httpmsg_.known)
+        value = shift_(value, offset);
+    for (size_t i = 0; i < httpmsg_.header_count; ++i) {
+        HttpHeader& header = httpmsg_.headers[i];
+        header.name = shift_(header.name, offset);
+        header.value = shift_(header.value, offset);
     }
-    return false;
 }
 
 // public
 
-RequestReceiver::RequestReceiver(HttpRequest& httpmsg) :httpmsg_(httpmsg) {}
+RequestReceiver::RequestReceiver(HttpRequest& httpmsg,
+        const BodyPolicy& policy)
+    : httpmsg_(httpmsg), policy_(policy) {}
+
+char* RequestReceiver::prepare(size_t n) {
+    const char* old_base = buffer_.data();
+    char* room = buffer_.prepare(n);
+    if (head_done_ && old_base != buffer_.data())
+        rebase_(old_base);
+    return room;
+}
 
-bool RequestReceiver::append(const char* msg) {
+bool RequestReceiver::commit(size_t n) {
+    buffer_.commit(n);
     if (is_ok_)
         return true;
 
     if (head_done_) {
-        return append_body_(msg);
+        return append_body_();
     } else {
-        return fill_head_(httpmsg_, msg);
+        return fill_head_(httpmsg_);
     }
 }
 
+bool RequestReceiver::append(const char* data, size_t len) {
+    std::memcpy(prepare(len), data, len);
+    return commit(len);
+}
+
+ssize_t RequestReceiver::splice_body(int sock) {
+    ssize_t ret = httpmsg_.body.splice_from(sock, body_remaining_);
+    if (ret > 0) {
+        body_remaining_ -= ret;
+        if (body_remaining_ == 0) {
+            request_end_pos_ = body_begin_pos_;
+            is_ok_ = true;
+        }
+    }
+    return ret;
+}
+
+bool RequestReceiver::next() {
+    buffer_.consume(error_ ? buffer_.size() : request_end_pos_);
+    httpmsg_ = HttpRequest();
+    decoder_.reset();
+    head_scan_pos_ = body_begin_pos_ = request_end_pos_ = 0;
+    header_content_length_ = std::string::npos;
+    body_remaining_ = decoded_end_pos_ = 0;
+    error_ = 0;
+    chunked_transfer_encoding_ = is_ok_ = head_done_ = false;
+    // a pipelined request may be already received
+    return buffer_.empty() ? false : commit(0);
+}
+
 } // namespace webstab
@@ -32,25 +32,31 @@
 #include <string>
 
 // WebStable
+#include "http/ChunkedDecoder.h"
 #include "http/HttpRequest.h"
+#include "http/RecvBuffer.h"
+#include "http/RequestBody.h"
 
 namespace webstab {
 
 class RequestReceiver {
 
     HttpRequest& httpmsg_;
+    const BodyPolicy& policy_;
 
-    // check
-    std::string body_cache_;
-    std::string head_cache_;
-    std::string chunk_cache_;
+    // receive buffer of the connection, the request points into it
+    RecvBuffer buffer_;
 
-    size_t body_begin_pos_ = std::string::npos;
-    size_t body_begin_pos_cache_ = 0;
+    // decodes the body in place when 'Transfer-Encoding' is 'chunked'
+    ChunkedDecoder decoder_;
+
+    size_t head_scan_pos_ = 0;
+    size_t body_begin_pos_ = 0;
+    size_t request_end_pos_ = 0;
     size_t header_content_length_ = std::string::npos;
-    size_t chunk_last_ = 0;
-    size_t chunk_pos_ = 0;
-    size_t chunk_base_ = 0;
+    size_t body_remaining_ = 0;
+    size_t decoded_end_pos_ = 0;
+    int error_ = 0;
 
     bool chunked_transfer_encoding_ = false;
     bool is_ok_ = false;
@@ -58,16 +64,57 @@ class RequestReceiver {
 
 private:
 
-    bool fill_head_(HttpRequest& request, const char* msg);
+    bool fill_head_(HttpRequest& request);
 
     // append chunks when 'Transfer-Encoding' is 'chunked'
-    bool append_chunk_(const char* msg);
-    bool append_body_(const char* msg);
+    bool append_chunk_();
+    bool append_body_();
+
+    // the request cannot be received, reply with 'status'
+    bool fail_(int status);
+
+    // the buffer moved from 'old_base', shift the views of the request
+    void rebase_(const char* old_base);
 
 public:
 
-    RequestReceiver(HttpRequest& httpmsg);
-    bool append(const char* msg);
+    RequestReceiver(HttpRequest& httpmsg, const BodyPolicy& policy);
+
+    // room of at least 'n' bytes for recv() to fill in place
+    char* prepare(size_t n);
+
+    // 'n' bytes were received into the room returned by prepare(),
+    // returns true when the request is complete
+    bool commit(size_t n);
+
+    bool append(const char* data, size_t len);
+
+    // the rest of the body goes to its temporary file with splice_body()
+    // instead of the buffer
+    inline bool splicing() const {
+        return body_remaining_ && httpmsg_.body.spilled();
+    }
+
+    // moves the body from 'sock' to its temporary file, returns as recv()
+    ssize_t splice_body(int sock);
+
+    // starts the next request of a keep-alive connection, the pipelined
+    // bytes after the current request are kept and parsed
+    bool next();
+
+    inline bool done() const { return is_ok_; }
+
+    // the head is received and parsed
+    inline bool head_done() const { return head_done_; }
+
+    // nothing of the next request is received yet
+    inline bool idle() const { return !is_ok_ && buffer_.empty(); }
+
+    // the request cannot be received, no more data will be accepted
+    inline bool bad() const { return error_ != 0; }
+
+    // status code to reply when bad()
+    inline int error() const { return error_; }
 
 }; // class RequestReceiver
 
@@ -0,0 +1,153 @@
+// File:     src/http/ResponseWriter.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ResponseWriter.h"
+
+// C
+#include <cstring>
+#include <ctime>
+
+// WebStable
+#include "http/HttpDate.h"
+
+namespace webstab {
+
+namespace {
+
+struct StatusLine {
+    int status;
+    std::string_view line;
+};
+
+// 'HTTP/1.1 ' is 9 bytes and the code 3, the reason starts at 13
+constexpr size_t ReasonOffset = 13;
+
+constexpr StatusLine StatusLines[] = {
+    { 200, "HTTP/1.1 200 OK\r\n" },
+    { 204, "HTTP/1.1 204 No Content\r\n" },
+    { 206, "HTTP/1.1 206 Partial Content\r\n" },
+    { 301, "HTTP/1.1 301 Moved Permanently\r\n" },
+    { 302, "HTTP/1.1 302 Found\r\n" },
+    { 304, "HTTP/1.1 304 Not Modified\r\n" },
+    { 400, "HTTP/1.1 400 Bad Request\r\n" },
+    { 403, "HTTP/1.1 403 Forbidden\r\n" },
+    { 404, "HTTP/1.1 404 Not Found\r\n" },
+    { 405, "HTTP/1.1 405 Method Not Allowed\r\n" },
+    { 408, "HTTP/1.1 408 Request Timeout\r\n" },
+    { 412, "HTTP/1.1 412 Precondition Failed\r\n" },
+    { 413, "HTTP/1.1 413 Payload Too Large\r\n" },
+    { 416, "HTTP/1.1 416 Range Not Satisfiable\r\n" },
+    { 431, "HTTP/1.1 431 Request Header Fields Too Large\r\n" },
+    { 500, "HTTP/1.1 500 Internal Server Error\r\n" },
+    { 501, "HTTP/1.1 501 Not Implemented\r\n" },
+    { 503, "HTTP/1.1 503 Service Unavailable\r\n" },
+};
+
+// unknown codes are answered as 500
+const StatusLine& status_line_(int status) noexcept {
+    for (const StatusLine& e : StatusLines)
+        if (e.status == status) return e;
+    return status_line_(500);
+}
+
+// 'Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n'
+constexpr size_t DateLineLength = HttpDateLength + 8;
+
+struct DateCache {
+    std::time_t second = -1;
+    char line[DateLineLength];
+};
+
+thread_local DateCache date_cache_;
+
+const char* date_line_() noexcept {
+    timespec now {};
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    if (now.tv_sec != date_cache_.second) {
+        // the second changed, format it again
+        char date[HttpDateLength + 1];
+        format_http_date(now.tv_sec, date);
+        std::memcpy(date_cache_.line, "Date: ", 6);
+        std::memcpy(date_cache_.line + 6, date, HttpDateLength);
+        std::memcpy(date_cache_.line + 6 + HttpDateLength, "\r\n", 2);
+        date_cache_.second = now.tv_sec;
+    }
+    return date_cache_.line;
+}
+
+} // anonymous namespace
+
+std::string_view status_reason(int status) noexcept {
+    std::string_view line = status_line_(status).line;
+    return line.substr(ReasonOffset, line.size() - ReasonOffset - 2);
+}
+
+ResponseWriter::ResponseWriter(char* buf, size_t capacity) noexcept
+    : buf_(buf), capacity_(capacity) {}
+
+void ResponseWriter::append_(const char* data, size_t len) noexcept {
+    if (capacity_ - size_ < len) {
+        overflow_ = true;
+        return;
+    }
+    std::memcpy(buf_ + size_, data, len);
+    size_ += len;
+}
+
+void ResponseWriter::status(int status) noexcept {
+    std::string_view line = status_line_(status).line;
+    append_(line.data(), line.size());
+}
+
+void ResponseWriter::date() noexcept {
+    append_(date_line_(), DateLineLength);
+}
+
+void ResponseWriter::header(std::string_view name,
+        std::string_view value) noexcept {
+    append_(name.data(), name.size());
+    append_(": ", 2);
+    append_(value.data(), value.size());
+    append_("\r\n", 2);
+}
+
+void ResponseWriter::header(std::string_view name, size_t value) noexcept {
+    // digits are written backwards from the end
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    header(name, std::string_view(p, digits + sizeof(digits) - p));
+}
+
+size_t ResponseWriter::finish() noexcept {
+    append_("\r\n", 2);
+    return overflow_ ? 0 : size_;
+}
+
+} // namespace webstab
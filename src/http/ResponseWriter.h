@@ -0,0 +1,74 @@
+// File:     src/http/ResponseWriter.h
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+#ifndef WEBSTABLE_HTTP_RESPONSEWRITER_H
+#define WEBSTABLE_HTTP_RESPONSEWRITER_H
+
+// C++
+#include <cstddef>
+#include <string_view>
+
+namespace webstab {
+
+// reason phrase of a status code, 'Not Found' for 404
+std::string_view status_reason(int status) noexcept;
+
+// serialises a response head into a caller provided buffer, in the order
+// of the calls and without any allocation
+class ResponseWriter {
+    char* buf_;
+    size_t capacity_;
+    size_t size_ = 0;
+    bool overflow_ = false;
+
+private:
+    void append_(const char* data, size_t len) noexcept;
+
+public:
+    ResponseWriter(char* buf, size_t capacity) noexcept;
+
+    // 'HTTP/1.1 200 OK', from a precomputed table
+    void status(int status) noexcept;
+
+    // 'Date: Sun, 06 Nov 1994 08:49:37 GMT', formatted once per second
+    // per thread
+    void date() noexcept;
+
+    void header(std::string_view name, std::string_view value) noexcept;
+    void header(std::string_view name, size_t value) noexcept;
+
+    // ends the head with an empty line, returns its length, or 0 if it
+    // did not fit in the buffer
+    size_t finish() noexcept;
+
+    inline const char* data() const noexcept { return buf_; }
+
+}; // class ResponseWriter
+
+} // namespace webstab
+
+#endif // WEBSTABLE_HTTP_RESPONSEWRITER_H
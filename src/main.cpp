@@ -24,6 +24,10 @@
  * SOFTWARE.
  */
 
+// C++
+#include <iostream>
+
+// WebStable
 #include "app/ArgsParser.h"
 #include "app/Config.h"
 #include "core/WebServer.h"
@@ -32,6 +36,12 @@ int main(int argc, char* argv[]) {
     webstab::ArgsParser args(argc, argv);
     args.parse();
     webstab::Config config(args.conf_filepath());
-    webstab::WebServer server(config);
-    return server.exec();
+    try {
+        // the [static] options are read when the server compiles them
+        webstab::WebServer server(config);
+        return server.exec();
+    } catch (const webstab::ConfigError& e) {
+        std::cerr << e.what() << std::endl;
+        return e.code();
+    }
 }
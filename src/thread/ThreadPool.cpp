@@ -26,12 +26,16 @@
 
 #include "ThreadPool.h"
 
+// WebStable
+#include "core/Metrics.h"
+
 namespace webstab {
 
 ThreadPool::ThreadPool(size_t thread_num) {
+    // set before the threads start, a thread that saw it false would exit
+    running_ = true;
     for (size_t i = 0; i < thread_num; ++i)
         threads_.emplace_back(thread_routine, this);
-    running_ = true;
 }
 
 ThreadPool::~ThreadPool() {
@@ -76,18 +80,25 @@ bool ThreadPool::is_running() {
 void ThreadPool::push(nano::sock_t sock) {
     mutex_.lock();
     // push task to task queue
-    task_queue_.push(sock);
+    task_queue_.emplace(sock, Metrics::now());
     // signal to thread
     cond_.notify_one();
     
     mutex_.unlock();
 }
 
+// queued
+size_t ThreadPool::queued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return task_queue_.size();
+}
+
 void thread_routine(ThreadPool* tp) {
     // if is running
     try {
         while (tp->running_) {
             nano::sock_t sock = INVALID_SOCKET;
+            uint64_t queued_at = 0;
             {    
                 std::unique_lock<std::mutex> lock(tp->mutex_);
                 // wait for task
@@ -98,9 +109,11 @@ void thread_routine(ThreadPool* tp) {
                     continue;
                 }
                 // get task
-                sock = tp->task_queue_.front();
+                sock = tp->task_queue_.front().first;
+                queued_at = tp->task_queue_.front().second;
                 tp->task_queue_.pop();
             }
+            Metrics::record(Stage::Queue, queued_at, Metrics::now());
             // execute task
             tp->task_(sock);
 
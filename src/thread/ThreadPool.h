@@ -29,7 +29,9 @@
 #define WEBSTABLE_THREAD_THREADPOOL_H
 
 // C++
+#include <cstdint>
 #include <queue>
+#include <utility>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -51,7 +53,9 @@ public:
 
 private:
     task_t task_;
-    std::queue<nano::sock_t> task_queue_;
+
+    // sockets and the time they were pushed at
+    std::queue<std::pair<nano::sock_t, uint64_t>> task_queue_;
     std::vector<std::thread> threads_;
     std::mutex mutex_;
     std::condition_variable cond_;
@@ -69,6 +73,9 @@ public:
     bool is_running();
     void push(nano::sock_t sock);
 
+    // connections waiting for a thread
+    size_t queued();
+
 }; // class ThreadPool
 
 void thread_routine(ThreadPool* tp);
@@ -27,7 +27,9 @@
 #include "TimerWheel.h"
 
 // C++
+#include <algorithm>
 #include <chrono>
+#include <utility>
 
 namespace webstab {
 
@@ -63,20 +65,29 @@ TimerWheel::TimerWheel(std::size_t wheel_size)
     size_(wheel_size),
     wheel_(size_) {}
 
+void TimerWheel::set_on_expire(std::function<void()> on_expire) {
+    on_expire_ = std::move(on_expire);
+}
+
 void TimerWheel::start() {
     if (running_) return;
     running_ = true;
     thread_ = std::thread([this]() {
         while (this->running_) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
-            std::lock_guard<std::mutex> lock(mutex_);
-            auto& list = wheel_[index_];
-            if (++index_ == size_) index_ = 0;
-            for (const auto& socket : list) {
-                map_.erase(socket);
-                nano::close_socket(socket);
+            bool expired = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto& list = wheel_[index_];
+                if (++index_ == size_) index_ = 0;
+                for (const auto& socket : list) {
+                    map_.erase(socket);
+                    expired_.push_back(socket);
+                }
+                expired = !list.empty();
+                list.clear();
             }
-            list.clear();
+            if (expired && on_expire_) on_expire_();
         }
     });
     thread_.detach();
@@ -93,7 +104,18 @@ bool TimerWheel::timing(nano::sock_t socket) {
 
 bool TimerWheel::cancel(nano::sock_t socket) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return remove_(socket);
+    if (remove_(socket)) return true;
+    auto it = std::find(expired_.begin(), expired_.end(), socket);
+    if (it == expired_.end()) return false;
+    *it = expired_.back();
+    expired_.pop_back();
+    return true;
+}
+
+void TimerWheel::take_expired(std::vector<nano::sock_t>& sockets) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sockets.swap(expired_);
+    expired_.clear();
 }
 
 bool TimerWheel::update(nano::sock_t socket) {
@@ -102,4 +124,39 @@ bool TimerWheel::update(nano::sock_t socket) {
     return insert_(socket);
 }
 
+std::size_t TimerWheel::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return map_.size();
+}
+
+std::size_t TimerWheel::memory() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a map node is the value and the pointer to the next node
+    std::size_t bytes = map_.bucket_count() * sizeof(void*)
+        + map_.size() * (sizeof(void*) + sizeof(decltype(map_)::value_type));
+    bytes += wheel_.capacity() * sizeof(std::vector<nano::sock_t>);
+    for (const auto& list : wheel_)
+        bytes += list.capacity() * sizeof(nano::sock_t);
+    bytes += expired_.capacity() * sizeof(nano::sock_t);
+    return bytes;
+}
+
+void TimerWheel::resize(std::size_t wheel_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wheel_size == 0 || wheel_size == size_) return;
+    std::vector<std::vector<nano::sock_t>> wheel(wheel_size);
+    for (std::size_t i = 0; i < size_; ++i) {
+        // the slot 'index_' expires at the next tick
+        std::size_t ticks = (i + size_ - index_) % size_;
+        std::size_t in = std::min(ticks, wheel_size - 1);
+        for (nano::sock_t socket : wheel_[i]) {
+            map_[socket] = std::pair{in, wheel[in].size()};
+            wheel[in].push_back(socket);
+        }
+    }
+    wheel_.swap(wheel);
+    size_ = wheel_size;
+    index_ = 0;
+}
+
 } // namespace webstab
@@ -29,6 +29,7 @@
 #define WEBSTABLE_THREAD_TIMEWHEEL_H
 
 // C++
+#include <functional>
 #include <vector>
 #include <unordered_map>
 #include <thread>
@@ -42,13 +43,19 @@ namespace webstab {
 class TimerWheel {
 
     std::size_t index_;
-    const std::size_t size_;
+    std::size_t size_;
     std::vector<std::vector<nano::sock_t>> wheel_;
     std::thread thread_;
     std::mutex mutex_;
     std::unordered_map<nano::sock_t, std::pair<std::size_t, std::size_t>> map_;
     bool running_ = false;
 
+    // sockets that timed out, kept until the owner takes them. the owner
+    // is told when there are new ones and closes them itself, the wheel
+    // never closes a socket
+    std::vector<nano::sock_t> expired_;
+    std::function<void()> on_expire_;
+
 private:
     bool insert_(nano::sock_t socket);
     bool remove_(nano::sock_t socket);
@@ -57,12 +64,32 @@ public:
     explicit TimerWheel(std::size_t wheel_size);
     ~TimerWheel() = default;
 
+    // set before start(), called on the timer thread
+    void set_on_expire(std::function<void()> on_expire);
+
     void start();
     void stop();
     bool timing(nano::sock_t socket);
-    bool cancel(nano::sock_t socket);
     bool update(nano::sock_t socket);
 
+    // stops timing 'socket', and drops it from the expired sockets that
+    // were not taken yet. false if it was in neither
+    bool cancel(nano::sock_t socket);
+
+    // moves the expired sockets to 'sockets'
+    void take_expired(std::vector<nano::sock_t>& sockets);
+
+    // sockets being timed
+    std::size_t size();
+
+    // heap bytes held by the map and the wheel, an estimate that leaves
+    // out the allocator's own overhead
+    std::size_t memory();
+
+    // changes the timeout to 'wheel_size' seconds, sockets that are being
+    // timed keep their remaining time up to the new timeout
+    void resize(std::size_t wheel_size);
+
 }; // class TimerWheel
 
 } // namespace webstab
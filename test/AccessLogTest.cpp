@@ -0,0 +1,137 @@
+// File:     test/AccessLogTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the access log written by its own thread into a temporary directory
+
+// C
+#include <cstdio>
+#include <cstdlib>
+
+// C++
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Linux
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/AccessLog.h"
+#include "http/HttpParser.h"
+
+namespace webstab {
+
+namespace {
+
+// a directory for the log file, removed with the fixture
+class AccessLogTest : public ::testing::Test {
+protected:
+    std::string dir_;
+    std::string path_;
+    HttpRequest request_;
+
+    void SetUp() override {
+        char dir_template[] = "/tmp/webstable-log-XXXXXX";
+        ASSERT_NE(::mkdtemp(dir_template), nullptr);
+        dir_ = dir_template;
+        path_ = dir_ + "/access.log";
+        static constexpr std::string_view head = "GET /a\"b HTTP/1.1\r\n"
+            "User-Agent: test\r\n\r\n";
+        ASSERT_TRUE(parse_request_head(head.data(), head.size(), request_));
+    }
+
+    void TearDown() override {
+        ::unlink(path_.c_str());
+        ::unlink((path_ + ".1").c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    // the content of 'path'
+    static std::string read_(const std::string& path) {
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+};
+
+} // anonymous namespace
+
+TEST_F(AccessLogTest, Line) {
+    {
+        AccessLog log(path_, 0, AccessLog::Overflow::Drop);
+        log.log("127.0.0.1", request_, 200, 5, 42);
+    }
+    std::string line = read_(path_);
+    EXPECT_EQ(line.compare(0, 15, "127.0.0.1 - - ["), 0) << line;
+    size_t end = line.find("] ");
+    ASSERT_NE(end, std::string::npos) << line;
+    EXPECT_EQ(line.substr(end + 2),
+        "\"GET /a\\x22b HTTP/1.1\" 200 5 \"-\" \"test\" 42\n");
+}
+
+// the lines of every thread reach the file when the log is destroyed
+TEST_F(AccessLogTest, Threads) {
+    {
+        AccessLog log(path_, 0, AccessLog::Overflow::Block);
+        std::thread threads[4];
+        for (std::thread& thread : threads) {
+            thread = std::thread([&log, this] {
+                for (int i = 0; i < 1000; ++i)
+                    log.log("::1", request_, 404, 0, 1);
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+    }
+    std::string lines = read_(path_);
+    size_t count = 0;
+    for (size_t pos = 0; (pos = lines.find("::1 - - [", pos))
+            != std::string::npos; ++pos)
+        ++count;
+    EXPECT_EQ(count, 4000u);
+}
+
+TEST_F(AccessLogTest, Reopen) {
+    AccessLog log(path_, 0, AccessLog::Overflow::Drop);
+    log.log("10.0.0.1", request_, 200, 1, 1);
+    ASSERT_EQ(std::rename(path_.c_str(), (path_ + ".1").c_str()), 0);
+    log.reopen();
+    for (int i = 0; i < 100 && ::access(path_.c_str(), F_OK) != 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    log.log("10.0.0.2", request_, 200, 1, 1);
+    for (int i = 0; i < 100 && read_(path_).empty(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(read_(path_ + ".1").compare(0, 8, "10.0.0.1"), 0);
+    EXPECT_EQ(read_(path_).compare(0, 8, "10.0.0.2"), 0);
+}
+
+} // namespace webstab
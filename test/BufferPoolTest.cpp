@@ -0,0 +1,99 @@
+// File:     test/BufferPoolTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// pooled receive buffers and the receive buffer growing through them
+
+// C
+#include <cstring>
+
+// C++
+#include <string>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/BufferPool.h"
+#include "http/RecvBuffer.h"
+
+namespace webstab {
+
+TEST(BufferPool, Classes) {
+    const size_t sizes[] = { 1, 4096, 4097, 16384, 20000, 65536 };
+    const size_t classes[] = { 4096, 4096, 16384, 16384, 65536, 65536 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        size_t capacity = 0;
+        char* data = BufferPool::acquire(sizes[i], capacity);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(capacity, classes[i]) << sizes[i];
+        BufferPool::release(data, capacity);
+    }
+}
+
+TEST(BufferPool, Oversized) {
+    size_t capacity = 0;
+    char* data = BufferPool::acquire(100000, capacity);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(capacity, 100000u);
+    std::memset(data, 'x', capacity);
+    BufferPool::release(data, capacity);
+}
+
+TEST(BufferPool, Reuse) {
+    size_t capacity = 0;
+    char* first = BufferPool::acquire(100, capacity);
+    BufferPool::release(first, capacity);
+    char* again = BufferPool::acquire(4000, capacity);
+    EXPECT_EQ(again, first);
+    EXPECT_EQ(capacity, 4096u);
+    BufferPool::release(again, capacity);
+}
+
+TEST(RecvBuffer, Grows) {
+    std::string expected;
+    RecvBuffer buffer;
+    for (int i = 0; i < 5000; ++i) {
+        std::string piece = std::to_string(i) + ",";
+        buffer.append(piece.data(), piece.size());
+        expected += piece;
+    }
+    ASSERT_EQ(std::string(buffer.data(), buffer.size()), expected);
+
+    buffer.consume(2);
+    buffer.erase(3, 4);
+    expected.erase(0, 2);
+    expected.erase(3, 4);
+    EXPECT_EQ(std::string(buffer.data(), buffer.size()), expected);
+
+    buffer.consume(buffer.size());
+    EXPECT_TRUE(buffer.empty());
+    char* room = buffer.prepare(10);
+    std::memcpy(room, "0123456789", 10);
+    buffer.commit(10);
+    EXPECT_EQ(std::string(buffer.data(), buffer.size()), "0123456789");
+}
+
+} // namespace webstab
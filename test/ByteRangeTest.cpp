@@ -0,0 +1,129 @@
+// File:     test/ByteRangeTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the Range header against representations of a known size
+
+// C++
+#include <string>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/ByteRange.h"
+
+namespace webstab {
+
+namespace {
+
+// the ranges of 'set' as 'first-last,...'
+std::string ranges_(const RangeSet& set) {
+    std::string text;
+    for (size_t i = 0; i < set.count; ++i) {
+        if (i) text += ',';
+        text += std::to_string(set.ranges[i].first) + '-'
+            + std::to_string(set.ranges[i].last);
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+TEST(ByteRange, Closed) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("bytes=0-99", 1000, set), RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-99");
+    EXPECT_EQ(parse_range("bytes=900-2000", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "900-999");
+}
+
+TEST(ByteRange, OpenEnded) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("bytes=500-", 1000, set), RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "500-999");
+}
+
+TEST(ByteRange, Suffix) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("bytes=-200", 1000, set), RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "800-999");
+    EXPECT_EQ(parse_range("bytes=-5000", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-999");
+    EXPECT_EQ(parse_range("bytes=-0", 1000, set),
+        RangeResult::NotSatisfiable);
+}
+
+TEST(ByteRange, PastEnd) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("bytes=1000-", 1000, set),
+        RangeResult::NotSatisfiable);
+    EXPECT_EQ(parse_range("bytes=2000-3000, 1000-", 1000, set),
+        RangeResult::NotSatisfiable);
+    EXPECT_EQ(parse_range("bytes=0-", 0, set), RangeResult::NotSatisfiable);
+    // one satisfiable range is enough
+    EXPECT_EQ(parse_range("bytes=2000-, 0-0", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-0");
+}
+
+TEST(ByteRange, Invalid) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("items=0-1", 1000, set), RangeResult::Ignore);
+    EXPECT_EQ(parse_range("bytes=5-1", 1000, set), RangeResult::Ignore);
+    EXPECT_EQ(parse_range("bytes=a-b", 1000, set), RangeResult::Ignore);
+    EXPECT_EQ(parse_range("bytes=5", 1000, set), RangeResult::Ignore);
+    EXPECT_EQ(parse_range("bytes=", 1000, set), RangeResult::Ignore);
+}
+
+TEST(ByteRange, Merged) {
+    RangeSet set;
+    EXPECT_EQ(parse_range("bytes=0-99, 100-199, 300-399", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-199,300-399");
+    EXPECT_EQ(parse_range("bytes=0-499, 200-", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-999");
+    EXPECT_EQ(parse_range("bytes=-100, 0-99", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(ranges_(set), "0-99,900-999");
+}
+
+TEST(ByteRange, ManyOverlapping) {
+    RangeSet set;
+    std::string value = "bytes=0-";
+    for (int i = 0; i < 15; ++i) value += ",0-";
+    EXPECT_EQ(parse_range(value, 1000, set), RangeResult::Ignore);
+    EXPECT_EQ(parse_range("bytes=500-599, 0-99, 200-299", 1000, set),
+        RangeResult::Ignore);
+    // many ranges in order are served
+    EXPECT_EQ(parse_range("bytes=0-0, 2-2, 4-4, 6-6", 1000, set),
+        RangeResult::Satisfiable);
+    EXPECT_EQ(set.count, 4u);
+}
+
+} // namespace webstab
@@ -0,0 +1,126 @@
+// File:     test/ChunkedDecoderTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the chunked decoder, fed the body in pieces as recv() would return it
+
+// C++
+#include <string>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/ChunkedDecoder.h"
+
+namespace webstab {
+
+namespace {
+
+// what the decoder made of a body
+struct Decoded {
+    ssize_t result = -2;
+    std::string data;
+    std::string trailers;
+    std::string rest;
+};
+
+// decodes 'body' received 'piece' bytes at a time, keeping the buffer
+// the way the receiver does
+Decoded decode_(const std::string& body, size_t piece) {
+    ChunkedDecoder decoder;
+    Decoded decoded;
+    std::string buffer;
+    size_t data_end = 0, pos = 0;
+    for (; pos < body.size() && decoded.result == -2; pos += piece) {
+        buffer.append(body, pos, piece);
+        size_t from = data_end + decoder.trailers_length();
+        size_t length = buffer.size() - from;
+        decoded.result = decoder.decode(&buffer[from], length);
+        if (decoded.result == -1) return decoded;
+        data_end += length;
+        size_t trailers_end = data_end + decoder.trailers_length();
+        buffer.resize(trailers_end
+            + (decoded.result > 0 ? decoded.result : 0));
+    }
+    decoded.data = buffer.substr(0, data_end);
+    decoded.trailers = buffer.substr(data_end, decoder.trailers_length());
+    // the next request goes on after the received bytes
+    decoded.rest = buffer.substr(data_end + decoder.trailers_length());
+    if (pos < body.size()) decoded.rest.append(body, pos);
+    return decoded;
+}
+
+} // anonymous namespace
+
+TEST(ChunkedDecoder, AnySplit) {
+    std::string body = "5\r\nhello\r\n1a;name=\"v\"\r\n"
+        "abcdefghijklmnopqrstuvwxyz\r\n0\r\nX-A: 1\r\nX-B: 2\r\n\r\nGET";
+    for (size_t piece = 1; piece <= body.size(); ++piece) {
+        Decoded decoded = decode_(body, piece);
+        EXPECT_GE(decoded.result, 0) << "piece " << piece;
+        EXPECT_EQ(decoded.data, "helloabcdefghijklmnopqrstuvwxyz");
+        EXPECT_EQ(decoded.trailers, "X-A: 1\r\nX-B: 2\r\n");
+        EXPECT_EQ(decoded.rest, "GET");
+    }
+}
+
+TEST(ChunkedDecoder, BareLF) {
+    Decoded decoded = decode_("3\nabc\n0\n\n", 1);
+    EXPECT_EQ(decoded.result, 0);
+    EXPECT_EQ(decoded.data, "abc");
+}
+
+TEST(ChunkedDecoder, Incomplete) {
+    EXPECT_EQ(decode_("5\r\nhel", 2).result, -2);
+    EXPECT_EQ(decode_("0\r\nX-A: 1\r\n", 4).result, -2);
+}
+
+TEST(ChunkedDecoder, Malformed) {
+    EXPECT_EQ(decode_("\r\nhello\r\n0\r\n\r\n", 1).result, -1);
+    EXPECT_EQ(decode_("5x\r\nhello\r\n0\r\n\r\n", 1).result, -1);
+    EXPECT_EQ(decode_("5\r\nhelloX\r\n0\r\n\r\n", 1).result, -1);
+    EXPECT_EQ(decode_("5\rhello\r\n0\r\n\r\n", 1).result, -1);
+}
+
+TEST(ChunkedDecoder, OversizedLength) {
+    std::string size(sizeof(size_t) * 2 + 1, 'f');
+    EXPECT_EQ(decode_(size + "\r\nx\r\n0\r\n\r\n", 3).result, -1);
+    // leading zeros do not count
+    EXPECT_EQ(decode_("000000000000000000001\r\nx\r\n0\r\n\r\n", 3).result, 0);
+}
+
+TEST(ChunkedDecoder, TrailersLimit) {
+    std::string line = "X-Pad: " + std::string(90, 'a') + "\r\n";
+    std::string trailers;
+    while (trailers.size() + line.size() <= 8192) trailers += line;
+    Decoded decoded = decode_("0\r\n" + trailers + "\r\n", 700);
+    EXPECT_EQ(decoded.result, 0);
+    EXPECT_EQ(decoded.trailers, trailers);
+    EXPECT_EQ(decode_("0\r\n" + trailers + line + "\r\n", 700).result, -1);
+    EXPECT_EQ(decode_("0\r\n" + trailers + line + "\r\n", 1).result, -1);
+}
+
+} // namespace webstab
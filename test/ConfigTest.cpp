@@ -0,0 +1,132 @@
+// File:     test/ConfigTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the values of a configuration file checked when it is read
+
+// C
+#include <cstdint>
+#include <cstdlib>
+
+// C++
+#include <string>
+
+// Linux
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "app/Config.h"
+
+// bench
+#include "BenchServer.h"
+
+namespace webstab {
+
+namespace {
+
+// loads a file of 'server_keys', a root and 'tcp_keys', returns the
+// error or ""
+std::string load_(const std::string& server_keys,
+        const std::string& tcp_keys = "") {
+    char path[] = "/tmp/webstable-config-XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd == -1) return "mkstemp";
+    ::close(fd);
+    bench::write_file(path, "[server]\n" + server_keys
+        + "\n[static]\nroot = /tmp\n[tcp]\n" + tcp_keys + '\n');
+    std::string error;
+    try {
+        Config::load(path);
+    } catch (const ConfigError& e) {
+        error = e.what();
+    }
+    ::unlink(path);
+    return error;
+}
+
+} // anonymous namespace
+
+TEST(ConfigCheck, Defaults) {
+    EXPECT_EQ(load_(""), "");
+}
+
+TEST(ConfigCheck, Numbers) {
+    EXPECT_EQ(load_("backlog = 1024\nmax_queue = 0\nkeepalive = 5"), "");
+    EXPECT_NE(load_("backlog = abc").find("backlog"), std::string::npos);
+    EXPECT_NE(load_("backlog = 12abc").find("backlog"), std::string::npos);
+    EXPECT_NE(load_("max_queue = -1").find("max_queue"), std::string::npos);
+    EXPECT_NE(load_("defer_accept = 99999999999").find("defer_accept"),
+        std::string::npos);
+    EXPECT_NE(load_("threads_num = 0").find("threads_num"),
+        std::string::npos);
+    EXPECT_NE(load_("keepalive = ").find("keepalive"), std::string::npos);
+}
+
+TEST(ConfigCheck, Sizes) {
+    EXPECT_EQ(load_("cache_size = 64m\nmax_body_size = 512"), "");
+    EXPECT_NE(load_("cache_size = 64x").find("cache_size"),
+        std::string::npos);
+    EXPECT_NE(load_("cache_size = -1").find("cache_size"),
+        std::string::npos);
+    EXPECT_NE(load_("cache_size = 1mb").find("cache_size"),
+        std::string::npos);
+    EXPECT_NE(load_("max_body_size = 99999999999999999g")
+        .find("max_body_size"), std::string::npos);
+}
+
+TEST(ConfigCheck, Tcp) {
+    EXPECT_EQ(load_("", "nodelay = off\nsndbuf = 256k\nlinger = 0"), "");
+    EXPECT_NE(load_("", "nodelay = yes").find("nodelay"), std::string::npos);
+    EXPECT_NE(load_("", "rcvbuf = 4x").find("rcvbuf"), std::string::npos);
+    EXPECT_NE(load_("", "sndbuf = 4g").find("sndbuf"), std::string::npos);
+    EXPECT_NE(load_("", "linger = -1").find("linger"), std::string::npos);
+    EXPECT_NE(load_("", "linger = on").find("linger"), std::string::npos);
+}
+
+TEST(ConfigCheck, FieldValues) {
+    EXPECT_EQ(load_("server_name = " + std::string(256, 'a')), "");
+    EXPECT_NE(load_("server_name = " + std::string(257, 'a'))
+        .find("server_name"), std::string::npos);
+    EXPECT_NE(load_("default_type = " + std::string(300, 'a'))
+        .find("default_type"), std::string::npos);
+    EXPECT_THROW(Config::check_field_value("k", "a\rb"), ConfigError);
+    EXPECT_NO_THROW(Config::check_field_value("k", "public, max-age=60"));
+}
+
+TEST(ConfigCheck, SizeUnits) {
+    EXPECT_EQ(Config::check_size("k", "16k", SIZE_MAX), 16384u);
+    EXPECT_EQ(Config::check_size("k", "2G", SIZE_MAX), 2ULL << 30);
+    EXPECT_EQ(Config::check_size("k", "512", SIZE_MAX), 512u);
+    EXPECT_THROW(Config::check_size("k", "3g", 2ULL << 30), ConfigError);
+    // the accessors read the values by the same rules
+    EXPECT_EQ(Config::parse_size("16K"), 16384u);
+    EXPECT_EQ(Config::parse_size("1m"), 1u << 20);
+    EXPECT_THROW(Config::parse_size("1mb"), ConfigError);
+}
+
+} // namespace webstab
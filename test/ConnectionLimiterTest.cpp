@@ -0,0 +1,119 @@
+// File:     test/ConnectionLimiterTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the caps on the connections open in total and from one client address
+
+// C
+#include <cstring>
+
+// Linux
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/ConnectionLimiter.h"
+
+namespace webstab {
+
+namespace {
+
+// the address of a client at 'ip', IPv4 or IPv6
+sockaddr_storage addr_(const char* ip) {
+    sockaddr_storage addr;
+    std::memset(&addr, 0, sizeof(addr));
+    auto& in = reinterpret_cast<sockaddr_in&>(addr);
+    auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+    if (::inet_pton(AF_INET, ip, &in.sin_addr) == 1) {
+        in.sin_family = AF_INET;
+    } else {
+        EXPECT_EQ(::inet_pton(AF_INET6, ip, &in6.sin6_addr), 1) << ip;
+        in6.sin6_family = AF_INET6;
+    }
+    return addr;
+}
+
+} // anonymous namespace
+
+// without a limit nothing is counted
+TEST(ConnectionLimiter, Unlimited) {
+    ConnectionLimiter limiter(0, 0);
+    for (int sock = 0; sock < 1000; ++sock)
+        EXPECT_TRUE(limiter.admit(sock, addr_("10.0.0.1")));
+    EXPECT_EQ(limiter.open(), 0u);
+    for (int sock = 0; sock < 1000; ++sock) limiter.release(sock);
+    EXPECT_EQ(limiter.open(), 0u);
+}
+
+TEST(ConnectionLimiter, Total) {
+    ConnectionLimiter limiter(2, 0);
+    EXPECT_TRUE(limiter.admit(5, addr_("10.0.0.1")));
+    EXPECT_TRUE(limiter.admit(6, addr_("10.0.0.2")));
+    EXPECT_FALSE(limiter.admit(7, addr_("10.0.0.3")));
+    EXPECT_EQ(limiter.open(), 2u);
+    limiter.release(5);
+    EXPECT_TRUE(limiter.admit(7, addr_("10.0.0.3")));
+}
+
+TEST(ConnectionLimiter, PerPeer) {
+    ConnectionLimiter limiter(0, 2);
+    EXPECT_TRUE(limiter.admit(5, addr_("10.0.0.1")));
+    EXPECT_TRUE(limiter.admit(6, addr_("10.0.0.1")));
+    EXPECT_FALSE(limiter.admit(7, addr_("10.0.0.1")));
+    EXPECT_TRUE(limiter.admit(8, addr_("10.0.0.2")));
+    EXPECT_EQ(limiter.open(), 3u);
+    limiter.release(6);
+    EXPECT_TRUE(limiter.admit(7, addr_("10.0.0.1")));
+}
+
+// a socket closed on two paths is released once
+TEST(ConnectionLimiter, ReleaseOnce) {
+    ConnectionLimiter limiter(2, 1);
+    EXPECT_TRUE(limiter.admit(5, addr_("10.0.0.1")));
+    EXPECT_FALSE(limiter.admit(6, addr_("10.0.0.1")));
+    limiter.release(6);
+    EXPECT_EQ(limiter.open(), 1u);
+    limiter.release(5);
+    limiter.release(5);
+    EXPECT_EQ(limiter.open(), 0u);
+    limiter.release(9);
+    EXPECT_EQ(limiter.open(), 0u);
+    EXPECT_TRUE(limiter.admit(5, addr_("10.0.0.1")));
+    EXPECT_TRUE(limiter.admit(6, addr_("10.0.0.2")));
+    EXPECT_FALSE(limiter.admit(7, addr_("10.0.0.3")));
+}
+
+// IPv4 counts as its IPv6-mapped form
+TEST(ConnectionLimiter, Mapped) {
+    ConnectionLimiter limiter(0, 1);
+    EXPECT_TRUE(limiter.admit(5, addr_("192.0.2.7")));
+    EXPECT_FALSE(limiter.admit(6, addr_("::ffff:192.0.2.7")));
+    EXPECT_TRUE(limiter.admit(6, addr_("2001:db8::7")));
+}
+
+} // namespace webstab
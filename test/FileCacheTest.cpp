@@ -0,0 +1,167 @@
+// File:     test/FileCacheTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the file cache against files changed on the disk
+
+// C
+#include <cstdio>
+#include <cstdlib>
+
+// C++
+#include <string>
+
+// Linux
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "file/FileCache.h"
+
+namespace webstab {
+
+namespace {
+
+bool write_file_(const std::string& path, const std::string& content) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+    bool ok = std::fwrite(content.data(), 1, content.size(), file)
+        == content.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+// a directory with 'app.js' and its precompressed 'app.js.gz'
+class FileCacheTest : public ::testing::Test {
+protected:
+    std::string dir_;
+    std::string path_;
+    CachePolicy policy_;
+
+    void SetUp() override {
+        char dir_template[] = "/tmp/webstable-cache-XXXXXX";
+        ASSERT_NE(::mkdtemp(dir_template), nullptr);
+        dir_ = dir_template;
+        path_ = dir_ + "/app.js";
+        ASSERT_TRUE(write_file_(path_, std::string(4096, 'a')));
+        ASSERT_TRUE(write_file_(path_ + ".gz", "first"));
+    }
+
+    void TearDown() override {
+        ::unlink((path_ + ".gz").c_str());
+        ::unlink((path_ + ".gz.new").c_str());
+        ::unlink(path_.c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    // replaces 'app.js.gz' the way a deployment would, by a rename
+    void replace_gzip_(const std::string& content) {
+        ASSERT_TRUE(write_file_(path_ + ".gz.new", content));
+        ASSERT_EQ(std::rename((path_ + ".gz.new").c_str(),
+            (path_ + ".gz").c_str()), 0);
+    }
+};
+
+} // anonymous namespace
+
+TEST_F(FileCacheTest, StaticGzip) {
+    FileCache cache;
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    ASSERT_TRUE(entry->has_gzip());
+    EXPECT_EQ(entry->gzip.content, "first");
+    EXPECT_EQ(cache.get_file(path_, policy_, true), entry);
+}
+
+TEST_F(FileCacheTest, Compressed) {
+    ASSERT_EQ(::unlink((path_ + ".gz").c_str()), 0);
+    FileCache cache;
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    ASSERT_TRUE(entry->has_gzip());
+    EXPECT_EQ(entry->gzip.content.compare(0, 2, "\x1f\x8b"), 0);
+    EXPECT_LT(entry->gzip.size, entry->identity.size);
+    // the variant has a validator of its own
+    EXPECT_NE(entry->gzip.etag, entry->identity.etag);
+}
+
+TEST_F(FileCacheTest, NotCompressible) {
+    FileCache cache;
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_);
+    ASSERT_TRUE(entry);
+    EXPECT_FALSE(entry->has_gzip());
+    EXPECT_EQ(entry->identity.content, std::string(4096, 'a'));
+}
+
+// a type that became compressible gets its gzip variant
+TEST_F(FileCacheTest, Compressible) {
+    FileCache cache;
+    ASSERT_TRUE(cache.get_file(path_, policy_));
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    EXPECT_TRUE(entry->has_gzip());
+}
+
+// the least recently used files leave a full cache
+TEST_F(FileCacheTest, Capacity) {
+    FileCache cache(6000);
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(cache.get_file(path_, policy_), entry);
+    std::string other = dir_ + "/other.txt";
+    ASSERT_TRUE(write_file_(other, std::string(4096, 'b')));
+    EXPECT_TRUE(cache.get_file(other, policy_));
+    ::unlink(other.c_str());
+    EXPECT_NE(cache.get_file(path_, policy_), entry);
+
+    entry = cache.get_file(path_, policy_);
+    cache.set_capacity(1000);
+    EXPECT_NE(cache.get_file(path_, policy_), entry);
+}
+
+TEST_F(FileCacheTest, GzipReplaced) {
+    FileCache cache;
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    replace_gzip_("second");
+    entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->gzip.content, "second");
+}
+
+TEST_F(FileCacheTest, GzipRemoved) {
+    FileCache cache;
+    FileCache::EntryPtr entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    ASSERT_EQ(::unlink((path_ + ".gz").c_str()), 0);
+    entry = cache.get_file(path_, policy_, true);
+    ASSERT_TRUE(entry);
+    // compressed from the file instead
+    EXPECT_NE(entry->gzip.content, "first");
+    EXPECT_TRUE(entry->gzip_path.empty());
+}
+
+} // namespace webstab
@@ -0,0 +1,112 @@
+// File:     test/GzipTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// gzip members, inflated again with zlib
+
+// C++
+#include <algorithm>
+#include <string>
+
+// googletest
+#include <gtest/gtest.h>
+
+// zlib
+#include <zlib.h>
+
+// WebStable
+#include "http/Gzip.h"
+
+namespace webstab {
+
+namespace {
+
+// the content of one gzip member, or "<error>"
+std::string gunzip_(const std::string& member) {
+    z_stream stream {};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) return "<error>";
+    std::string out(1 << 20, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(
+        member.data()));
+    stream.avail_in = static_cast<uInt>(member.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int ret = inflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return ret == Z_STREAM_END && stream.avail_in == 0 ? out : "<error>";
+}
+
+// text that compresses, but not to nothing
+std::string text_(size_t size) {
+    std::string text;
+    for (size_t i = 0; text.size() < size; ++i)
+        text += "line " + std::to_string(i * 7919 % 1000) + '\n';
+    text.resize(size);
+    return text;
+}
+
+} // anonymous namespace
+
+TEST(Gzip, Compress) {
+    std::string text = text_(100000), member;
+    ASSERT_TRUE(gzip_compress(text.data(), text.size(), 6, member));
+    EXPECT_LT(member.size(), text.size());
+    EXPECT_EQ(gunzip_(member), text);
+}
+
+TEST(GzipStream, Pieces) {
+    std::string text = text_(300000);
+    GzipStream stream;
+    for (size_t piece : { 1000, 4096, 65536 }) {
+        ASSERT_TRUE(stream.reset(1));
+        std::string member;
+        for (size_t pos = 0; pos < text.size(); pos += piece) {
+            size_t length = std::min(piece, text.size() - pos);
+            ASSERT_TRUE(stream.write(&text[pos], length,
+                pos + length == text.size(), member));
+        }
+        EXPECT_EQ(gunzip_(member), text) << "piece " << piece;
+    }
+}
+
+TEST(GzipStream, Reset) {
+    GzipStream stream;
+    std::string member;
+    EXPECT_FALSE(stream.write("a", 1, true, member));
+    ASSERT_TRUE(stream.reset(9));
+    ASSERT_TRUE(stream.write("abc", 3, false, member));
+    // a new member starts over, at another level too
+    ASSERT_TRUE(stream.reset(1));
+    member.clear();
+    ASSERT_TRUE(stream.write("hello", 5, true, member));
+    EXPECT_EQ(gunzip_(member), "hello");
+    ASSERT_TRUE(stream.reset(1));
+    member.clear();
+    ASSERT_TRUE(stream.write("", 0, true, member));
+    EXPECT_EQ(gunzip_(member), "");
+}
+
+} // namespace webstab
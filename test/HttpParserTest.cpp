@@ -0,0 +1,190 @@
+// File:     test/HttpParserTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// request heads, parsed from the bytes a client sends
+
+// C
+#include <cctype>
+
+// C++
+#include <string>
+#include <string_view>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/HttpParser.h"
+
+namespace webstab {
+
+namespace {
+
+// parses 'head' into 'request', false when it is refused
+bool parse_(std::string_view head, HttpRequest& request) {
+    return parse_request_head(head.data(), head.size(), request);
+}
+
+} // anonymous namespace
+
+TEST(FindEither, AnyOffset) {
+    std::string text(100, 'a');
+    for (size_t i = 0; i < text.size(); ++i) {
+        std::string line = text;
+        line[i] = '\n';
+        const char* end = line.data() + line.size();
+        EXPECT_EQ(find_either(line.data(), end, '\n', ':') - line.data(),
+            static_cast<ptrdiff_t>(i));
+        line[i] = ':';
+        EXPECT_EQ(find_either(line.data(), end, '\n', ':') - line.data(),
+            static_cast<ptrdiff_t>(i));
+    }
+    EXPECT_EQ(find_either(text.data(), text.data() + text.size(), 'b', 'c'),
+        text.data() + text.size());
+}
+
+TEST(HeadEnd, Complete) {
+    std::string_view head = "GET / HTTP/1.1\r\nHost: a\r\n\r\nrest";
+    EXPECT_EQ(find_head_end(head.data(), head.size()), head.size() - 4);
+    std::string_view bare = "GET / HTTP/1.1\nHost: a\n\nrest";
+    EXPECT_EQ(find_head_end(bare.data(), bare.size()), bare.size() - 4);
+}
+
+TEST(HeadEnd, Incomplete) {
+    std::string_view head = "GET / HTTP/1.1\r\nHost: a\r\n\r";
+    EXPECT_EQ(find_head_end(head.data(), head.size()), 0u);
+    EXPECT_EQ(find_head_end(head.data(), 0), 0u);
+    // a scan can go on from where the last one stopped
+    std::string_view whole = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+    EXPECT_EQ(find_head_end(whole.data(), whole.size(), head.size() - 3),
+        whole.size());
+}
+
+TEST(RequestHead, Fields) {
+    HttpRequest request;
+    ASSERT_TRUE(parse_("GET /a/b?c=d HTTP/1.1\r\nHost: example\r\n"
+        "X-Id:  7 \t\r\nConnection: close\r\n\r\n", request));
+    EXPECT_EQ(request.method, "GET");
+    EXPECT_EQ(request.path, "/a/b?c=d");
+    EXPECT_EQ(request.version, "HTTP/1.1");
+    EXPECT_EQ(request.header(HeaderHost), "example");
+    EXPECT_EQ(request.header("host"), "example");
+    // the other headers are kept in order of arrival
+    ASSERT_EQ(request.header_count, 1u);
+    EXPECT_EQ(request.headers[0].name, "X-Id");
+    EXPECT_EQ(request.headers[0].value, "7");
+    EXPECT_FALSE(request.keep_alive());
+}
+
+TEST(RequestHead, Malformed) {
+    HttpRequest request;
+    EXPECT_FALSE(parse_("GET /\r\n\r\n", request));
+    EXPECT_FALSE(parse_("GET / FTP/1.0\r\n\r\n", request));
+    EXPECT_FALSE(parse_(" / HTTP/1.1\r\n\r\n", request));
+    EXPECT_FALSE(parse_("GET / HTTP/1.1\r\nHost\r\n\r\n", request));
+    EXPECT_FALSE(parse_("GET / HTTP/1.1\r\n: a\r\n\r\n", request));
+}
+
+TEST(RequestHead, TooManyHeaders) {
+    std::string head = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i < HttpRequest::MaxHeaders; ++i)
+        head += "X-" + std::to_string(i) + ": a\r\n";
+    HttpRequest request;
+    EXPECT_TRUE(parse_(head + "\r\n", request));
+    EXPECT_FALSE(parse_(head + "X: a\r\n\r\n", request));
+}
+
+TEST(RequestHead, Persistent) {
+    HttpRequest request;
+    ASSERT_TRUE(parse_("GET / HTTP/1.1\r\n\r\n", request));
+    EXPECT_TRUE(request.keep_alive());
+    ASSERT_TRUE(parse_("GET / HTTP/1.0\r\n\r\n", request));
+    EXPECT_FALSE(request.keep_alive());
+    ASSERT_TRUE(parse_("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n",
+        request));
+    EXPECT_TRUE(request.keep_alive());
+}
+
+TEST(AcceptEncoding, Coding) {
+    EXPECT_TRUE(accepts_encoding("gzip, deflate, br", "gzip"));
+    EXPECT_TRUE(accepts_encoding("deflate;q=0.5 , GZIP;q=0.1", "gzip"));
+    EXPECT_FALSE(accepts_encoding("deflate, br", "gzip"));
+    EXPECT_FALSE(accepts_encoding("", "gzip"));
+    EXPECT_FALSE(accepts_encoding("gzipx", "gzip"));
+}
+
+TEST(AcceptEncoding, Qvalue) {
+    EXPECT_FALSE(accepts_encoding("gzip;q=0", "gzip"));
+    EXPECT_FALSE(accepts_encoding("gzip; q=0.000", "gzip"));
+    EXPECT_TRUE(accepts_encoding("*", "gzip"));
+    EXPECT_FALSE(accepts_encoding("*;q=0", "gzip"));
+    // the name wins over the wildcard
+    EXPECT_FALSE(accepts_encoding("*, gzip;q=0", "gzip"));
+    EXPECT_TRUE(accepts_encoding("*;q=0, gzip", "gzip"));
+}
+
+TEST(KnownHeader, Lookup) {
+    for (int i = 0; i < KnownHeaderCount; ++i) {
+        KnownHeader id = static_cast<KnownHeader>(i);
+        std::string name(known_header_name(id));
+        EXPECT_EQ(lookup_header(name), id) << name;
+        for (char& c : name) c = static_cast<char>(std::tolower(c));
+        EXPECT_EQ(lookup_header(name), id) << name;
+        for (char& c : name) c = static_cast<char>(std::toupper(c));
+        EXPECT_EQ(lookup_header(name), id) << name;
+    }
+    EXPECT_EQ(lookup_header(""), HeaderUnknown);
+    EXPECT_EQ(lookup_header("Hos"), HeaderUnknown);
+    EXPECT_EQ(lookup_header("X-Host"), HeaderUnknown);
+    EXPECT_EQ(lookup_header("Hosu"), HeaderUnknown);
+}
+
+TEST(KnownHeader, Iequals) {
+    EXPECT_TRUE(iequals("Content-Length", "content-LENGTH"));
+    EXPECT_FALSE(iequals("Content-Length", "Content-Lengt"));
+    EXPECT_FALSE(iequals("a@", "a`"));
+}
+
+TEST(TransferEncoding, ChunkedLast) {
+    EXPECT_EQ(check_transfer_encoding("chunked"), 0);
+    EXPECT_EQ(check_transfer_encoding("Chunked"), 0);
+    EXPECT_EQ(check_transfer_encoding(" chunked ,"), 0);
+}
+
+TEST(TransferEncoding, ChunkedNotLast) {
+    EXPECT_EQ(check_transfer_encoding(""), 400);
+    EXPECT_EQ(check_transfer_encoding("gzip"), 400);
+    EXPECT_EQ(check_transfer_encoding("chunked, gzip"), 400);
+    EXPECT_EQ(check_transfer_encoding("chunked, chunked"), 400);
+    EXPECT_EQ(check_transfer_encoding("xchunked"), 400);
+}
+
+TEST(TransferEncoding, OtherCodings) {
+    EXPECT_EQ(check_transfer_encoding("gzip, chunked"), 501);
+    EXPECT_EQ(check_transfer_encoding("deflate,chunked"), 501);
+}
+
+} // namespace webstab
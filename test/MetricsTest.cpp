@@ -0,0 +1,128 @@
+// File:     test/MetricsTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// counters and latencies of several threads exposed in the Prometheus
+// text format
+
+// C
+#include <cstdint>
+#include <cstdlib>
+
+// C++
+#include <string>
+#include <thread>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/Metrics.h"
+
+namespace webstab {
+
+namespace {
+
+// the exposed value of the sample 'sample', -1 when it is missing
+double value_(const std::string& sample) {
+    std::string out;
+    Metrics::expose(out);
+    size_t pos = out.find('\n' + sample + ' ');
+    if (pos == std::string::npos) return -1;
+    return std::atof(out.c_str() + pos + sample.size() + 2);
+}
+
+} // anonymous namespace
+
+TEST(Metrics, Counters) {
+    double requests = value_("webstable_requests_total");
+    ASSERT_NE(requests, -1);
+    Metrics::add(Counter::Requests, 3);
+    std::thread([] { Metrics::add(Counter::Requests, 2); }).join();
+    // the blocks of threads that exited still count
+    EXPECT_EQ(value_("webstable_requests_total"), requests + 5);
+}
+
+TEST(Metrics, Status) {
+    const std::string sample = "webstable_responses_total{code=\"4xx\"}";
+    double responses = value_(sample);
+    ASSERT_NE(responses, -1);
+    Metrics::add_status(404);
+    Metrics::add_status(431);
+    Metrics::add_status(99);
+    Metrics::add_status(600);
+    EXPECT_EQ(value_(sample), responses + 2);
+}
+
+TEST(Metrics, Gauges) {
+    Metrics::add_gauge("webstable_test_items", "Items.", [] {
+        return uint64_t(7);
+    });
+    std::string out;
+    Metrics::expose(out);
+    EXPECT_NE(out.find("# HELP webstable_test_items Items.\n"
+        "# TYPE webstable_test_items gauge\nwebstable_test_items 7\n"),
+        std::string::npos) << out;
+    Metrics::clear_gauges();
+    EXPECT_EQ(value_("webstable_test_items"), -1);
+}
+
+TEST(Metrics, OpenConnections) {
+    double open = value_("webstable_connections_open");
+    Metrics::add(Counter::ConnectionsAccepted, 4);
+    Metrics::add(Counter::ConnectionsClosed, 1);
+    EXPECT_EQ(value_("webstable_connections_open"), open + 3);
+}
+
+TEST(Latency, Buckets) {
+    for (uint64_t ns = 0; ns < 16; ++ns)
+        EXPECT_EQ(Metrics::bucket(ns), ns);
+    // every bucket is narrower than 1/16 of the values in it
+    for (uint64_t ns = 16; ns < (1UL << 30); ns += ns / 7 + 1) {
+        EXPECT_LE(Metrics::bucket(ns), Metrics::bucket(ns + 1));
+        EXPECT_LT(Metrics::bucket(ns), Metrics::bucket(ns + ns / 8));
+    }
+    EXPECT_EQ(Metrics::bucket((1UL << LatencyMaxBits) - 1),
+        LatencyBuckets - 1);
+    EXPECT_EQ(Metrics::bucket(UINT64_MAX), LatencyBuckets - 1);
+}
+
+TEST(Latency, Quantiles) {
+    std::thread([] {
+        for (int i = 0; i < 99; ++i)
+            Metrics::record(Stage::Flush, 0, 1000);
+        Metrics::record(Stage::Flush, 0, 1000000);
+    }).join();
+    const std::string name = "webstable_stage_seconds{stage=\"flush\",";
+    EXPECT_NEAR(value_(name + "quantile=\"0.5\"}"), 1e-6, 1e-6 / 16);
+    EXPECT_NEAR(value_(name + "quantile=\"0.99\"}"), 1e-6, 1e-6 / 16);
+    EXPECT_NEAR(value_(name + "quantile=\"0.999\"}"), 1e-3, 1e-3 / 16);
+    EXPECT_EQ(value_("webstable_stage_seconds_count{stage=\"flush\"}"),
+        100);
+    EXPECT_NEAR(value_("webstable_stage_seconds_sum{stage=\"flush\"}"),
+        1.099e-3, 1e-9);
+}
+
+} // namespace webstab
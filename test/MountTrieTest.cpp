@@ -0,0 +1,87 @@
+// File:     test/MountTrieTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// longest prefix matches of request paths on segment boundaries
+
+// C++
+#include <string>
+#include <string_view>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "app/MountTrie.h"
+
+namespace webstab {
+
+namespace {
+
+// the value of the mount of 'path' and the length of its prefix, as
+// 'value:length'
+std::string match_(const MountTrie& trie, std::string_view path) {
+    size_t length = 0;
+    int value = trie.match(path, length);
+    return std::to_string(value) + ':' + std::to_string(length);
+}
+
+} // anonymous namespace
+
+TEST(MountTrie, LongestPrefix) {
+    MountTrie trie;
+    trie.insert("/", 0);
+    trie.insert("/assets", 1);
+    trie.insert("/assets/img/", 2);
+    trie.insert("/api", 3);
+    EXPECT_EQ(match_(trie, "/"), "0:0");
+    EXPECT_EQ(match_(trie, "/index.html"), "0:0");
+    EXPECT_EQ(match_(trie, "/assets"), "1:7");
+    EXPECT_EQ(match_(trie, "/assets/a.css"), "1:7");
+    EXPECT_EQ(match_(trie, "/assets/img"), "2:11");
+    EXPECT_EQ(match_(trie, "/assets/img/a.png"), "2:11");
+    EXPECT_EQ(match_(trie, "/api/v1"), "3:4");
+}
+
+TEST(MountTrie, SegmentBoundary) {
+    MountTrie trie;
+    trie.insert("/", 0);
+    trie.insert("/assets", 1);
+    trie.insert("/assets2", 2);
+    EXPECT_EQ(match_(trie, "/assets2/a"), "2:8");
+    EXPECT_EQ(match_(trie, "/assets3"), "0:0");
+    EXPECT_EQ(match_(trie, "/asset"), "0:0");
+    EXPECT_EQ(match_(trie, "/assetsx/a"), "0:0");
+}
+
+TEST(MountTrie, NoRoot) {
+    MountTrie trie;
+    trie.insert("/docs", 7);
+    EXPECT_EQ(match_(trie, "/docs/a"), "7:5");
+    EXPECT_EQ(match_(trie, "/"), "-1:0");
+    EXPECT_EQ(match_(trie, "/doc"), "-1:0");
+}
+
+} // namespace webstab
@@ -0,0 +1,83 @@
+// File:     test/PathNormalizerTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// request targets reduced to file paths below a root
+
+// C++
+#include <string>
+#include <string_view>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/PathNormalizer.h"
+
+namespace webstab {
+
+namespace {
+
+// the normalised path of 'target', or "<refused>"
+std::string normalize_(std::string_view target) {
+    std::string path;
+    return normalize_path(target, path) ? path : "<refused>";
+}
+
+} // anonymous namespace
+
+TEST(PathNormalizer, Segments) {
+    EXPECT_EQ(normalize_("/"), "/");
+    EXPECT_EQ(normalize_("/a/b"), "/a/b");
+    EXPECT_EQ(normalize_("/a/./b/../c%20d?v=1#top"), "/a/c d");
+    EXPECT_EQ(normalize_("//a//b/"), "/a/b/");
+    EXPECT_EQ(normalize_("/a/b/."), "/a/b/");
+    EXPECT_EQ(normalize_("/a/.."), "/");
+}
+
+TEST(PathNormalizer, AboveRoot) {
+    EXPECT_EQ(normalize_("/.."), "<refused>");
+    EXPECT_EQ(normalize_("/a/../../b"), "<refused>");
+    // escapes are decoded before the segments are resolved
+    EXPECT_EQ(normalize_("/%2e%2e/etc/passwd"), "<refused>");
+    EXPECT_EQ(normalize_("/a%2f..%2f..%2fb"), "<refused>");
+}
+
+TEST(PathNormalizer, Escapes) {
+    EXPECT_EQ(normalize_("/%41%62c"), "/Abc");
+    EXPECT_EQ(normalize_("/a%00b"), "<refused>");
+    EXPECT_EQ(normalize_("/a%zz"), "<refused>");
+    EXPECT_EQ(normalize_("/a%2"), "<refused>");
+}
+
+TEST(PathNormalizer, Targets) {
+    EXPECT_EQ(normalize_("http://host/x/y?q"), "/x/y");
+    EXPECT_EQ(normalize_("http://host"), "/");
+    EXPECT_EQ(normalize_("x/y"), "<refused>");
+    EXPECT_EQ(normalize_("*"), "<refused>");
+    EXPECT_EQ(normalize_(""), "<refused>");
+}
+
+} // namespace webstab
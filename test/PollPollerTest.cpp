@@ -0,0 +1,100 @@
+// File:     test/PollPollerTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the poll() poller, watching pipes while others are erased
+
+// C++
+#include <algorithm>
+#include <vector>
+
+// Linux
+#include <poll.h>
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/PollPoller.h"
+
+namespace webstab {
+
+namespace {
+
+// the read ends reported ready by 'poller', sorted
+std::vector<int> ready_(PollPoller& poller) {
+    std::vector<iohub::fd_event_t> events;
+    poller.wait(events, 0);
+    std::vector<int> fds;
+    for (const iohub::fd_event_t& event : events) fds.push_back(event.first);
+    std::sort(fds.begin(), fds.end());
+    return fds;
+}
+
+} // anonymous namespace
+
+// the descriptor moved into the slot of an erased one keeps being
+// reported, and can itself be erased
+TEST(PollPoller, EraseMovesLast) {
+    int pipes[6][2];
+    PollPoller poller;
+    for (auto& p : pipes) {
+        ASSERT_EQ(::pipe(p), 0);
+        poller.insert(p[0], POLLIN);
+    }
+    poller.erase(pipes[1][0]);
+    poller.erase(pipes[5][0]);
+    poller.erase(pipes[2][0]);
+    EXPECT_EQ(poller.size(), 3u);
+    for (auto& p : pipes) ASSERT_EQ(::write(p[1], "x", 1), 1);
+    std::vector<int> expected = { pipes[0][0], pipes[3][0], pipes[4][0] };
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(ready_(poller), expected);
+
+    poller.erase(pipes[4][0]);
+    poller.erase(pipes[0][0]);
+    EXPECT_EQ(ready_(poller), std::vector<int>{ pipes[3][0] });
+    for (auto& p : pipes) {
+        ::close(p[0]);
+        ::close(p[1]);
+    }
+}
+
+TEST(PollPoller, Misuse) {
+    int p[2];
+    ASSERT_EQ(::pipe(p), 0);
+    PollPoller poller;
+    EXPECT_THROW(poller.erase(p[0]), iohub::IOHubExcept);
+    EXPECT_THROW(poller.modify(p[0], POLLIN), iohub::IOHubExcept);
+    poller.insert(p[0], POLLIN);
+    EXPECT_THROW(poller.insert(p[0], POLLIN), iohub::IOHubExcept);
+    poller.clear();
+    EXPECT_EQ(poller.size(), 0u);
+    ::close(p[0]);
+    ::close(p[1]);
+}
+
+} // namespace webstab
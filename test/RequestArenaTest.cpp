@@ -0,0 +1,72 @@
+// File:     test/RequestArenaTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the scratch memory of the request a thread replies to
+
+// C++
+#include <memory_resource>
+#include <string>
+#include <thread>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "core/RequestArena.h"
+
+namespace webstab {
+
+TEST(RequestArena, PerThread) {
+    std::pmr::memory_resource* mine = RequestArena::resource();
+    EXPECT_EQ(RequestArena::resource(), mine);
+
+    std::pmr::memory_resource* other = nullptr;
+    std::thread([&other] { other = RequestArena::resource(); }).join();
+    EXPECT_NE(other, mine);
+}
+
+TEST(RequestArena, Reset) {
+    RequestArena::reset();
+    void* first = RequestArena::resource()->allocate(100);
+    void* second = RequestArena::resource()->allocate(200);
+    EXPECT_NE(second, first);
+    RequestArena::reset();
+    EXPECT_EQ(RequestArena::resource()->allocate(100), first);
+    RequestArena::reset();
+}
+
+TEST(RequestArena, BeyondBlock) {
+    RequestArena::reset();
+    std::pmr::string text(RequestArena::resource());
+    text.assign(ArenaBlockSize * 4, 'x');
+    text += "end";
+    EXPECT_EQ(text.size(), ArenaBlockSize * 4 + 3);
+    EXPECT_EQ(text.substr(text.size() - 4), "xend");
+    text = std::pmr::string(RequestArena::resource());
+    RequestArena::reset();
+}
+
+} // namespace webstab
@@ -0,0 +1,302 @@
+// File:     test/RequestReceiverTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// the receiver, fed requests in the pieces recv() would return
+
+// C++
+#include <string>
+#include <string_view>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/RequestReceiver.h"
+
+namespace webstab {
+
+namespace {
+
+constexpr std::string_view Post = "POST /form HTTP/1.1\r\nHost: a\r\n"
+    "Content-Length: 11\r\n\r\nhello world";
+
+// the body of 'message', from memory or from its temporary file
+std::string body_(const HttpRequest& message) {
+    std::string body;
+    message.body.read([&body](std::string_view chunk) {
+        body.append(chunk);
+        return true;
+    });
+    return body;
+}
+
+// the status 'request' is refused with, 0 when it is received whole
+int receive_(std::string_view request) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    receiver.append(request.data(), request.size());
+    EXPECT_TRUE(receiver.done()) << request;
+    return receiver.bad() ? receiver.error() : 0;
+}
+
+} // anonymous namespace
+
+TEST(Receive, AnySplit) {
+    for (size_t split = 1; split < Post.size(); ++split) {
+        BodyPolicy policy;
+        HttpRequest message;
+        RequestReceiver receiver(message, policy);
+        EXPECT_FALSE(receiver.append(Post.data(), split));
+        ASSERT_TRUE(receiver.append(Post.data() + split, Post.size() - split))
+            << "split " << split;
+        EXPECT_FALSE(receiver.bad());
+        EXPECT_EQ(message.method, "POST");
+        EXPECT_EQ(message.path, "/form");
+        EXPECT_EQ(message.header("Host"), "a");
+        EXPECT_EQ(body_(message), "hello world");
+    }
+}
+
+TEST(Receive, ByteAtATime) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    size_t i = 0;
+    while (i < Post.size() && !receiver.append(&Post[i], 1)) ++i;
+    EXPECT_EQ(i, Post.size() - 1);
+    // the views follow the buffer when it grows
+    EXPECT_EQ(message.path, "/form");
+    EXPECT_EQ(message.header("Content-Length"), "11");
+    EXPECT_EQ(body_(message), "hello world");
+}
+
+TEST(Receive, Pipelined) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string requests = std::string(Post)
+        + "GET /next HTTP/1.1\r\nHost: a\r\n\r\nGET /third";
+    ASSERT_TRUE(receiver.append(requests.data(), requests.size()));
+    EXPECT_EQ(message.path, "/form");
+    ASSERT_TRUE(receiver.next());
+    EXPECT_EQ(message.path, "/next");
+    EXPECT_TRUE(message.body.empty());
+    EXPECT_FALSE(receiver.next());
+    EXPECT_FALSE(receiver.idle());
+    std::string_view rest = " HTTP/1.1\r\n\r\n";
+    ASSERT_TRUE(receiver.append(rest.data(), rest.size()));
+    EXPECT_EQ(message.path, "/third");
+    EXPECT_FALSE(receiver.next());
+    EXPECT_TRUE(receiver.idle());
+}
+
+TEST(Receive, Malformed) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string_view request = "GET /\r\n\r\n";
+    EXPECT_TRUE(receiver.append(request.data(), request.size()));
+    EXPECT_EQ(receiver.error(), 400);
+    std::string_view length = "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n";
+    RequestReceiver other(message, policy);
+    EXPECT_TRUE(other.append(length.data(), length.size()));
+    EXPECT_EQ(other.error(), 400);
+}
+
+TEST(Receive, HeadTooLarge) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string head = "GET / HTTP/1.1\r\nX: " + std::string(70000, 'a');
+    EXPECT_TRUE(receiver.append(head.data(), head.size()));
+    EXPECT_EQ(receiver.error(), 431);
+}
+
+TEST(Body, Spilled) {
+    BodyPolicy policy;
+    policy.buffer_size = 4;
+    for (size_t split = 1; split < Post.size(); ++split) {
+        HttpRequest message;
+        RequestReceiver receiver(message, policy);
+        receiver.append(Post.data(), split);
+        ASSERT_TRUE(receiver.append(Post.data() + split, Post.size() - split));
+        EXPECT_FALSE(receiver.bad());
+        EXPECT_TRUE(message.body.spilled()) << "split " << split;
+        EXPECT_EQ(message.body.size(), 11u);
+        EXPECT_EQ(body_(message), "hello world");
+    }
+}
+
+TEST(Body, ChunkedSpilled) {
+    BodyPolicy policy;
+    policy.buffer_size = 4;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string_view request = "POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n3\r\ndef\r\n0\r\n\r\n";
+    ASSERT_TRUE(receiver.append(request.data(), request.size()));
+    EXPECT_FALSE(receiver.bad());
+    EXPECT_TRUE(message.body.spilled());
+    EXPECT_EQ(body_(message), "abcdef");
+}
+
+TEST(Body, Chunked) {
+    std::string_view request = "POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+        "GET /next HTTP/1.1\r\nHost: a\r\n\r\n";
+    for (size_t split = 1; split < request.size(); ++split) {
+        BodyPolicy policy;
+        HttpRequest message;
+        RequestReceiver receiver(message, policy);
+        receiver.append(request.data(), split);
+        receiver.append(request.data() + split, request.size() - split);
+        ASSERT_TRUE(receiver.done()) << "split " << split;
+        EXPECT_FALSE(receiver.bad());
+        EXPECT_FALSE(message.body.spilled());
+        EXPECT_EQ(body_(message), "hello") << "split " << split;
+        ASSERT_TRUE(receiver.next());
+        EXPECT_EQ(message.path, "/next");
+    }
+}
+
+TEST(Body, TooLarge) {
+    BodyPolicy policy;
+    policy.max_size = 10;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    // refused by its length, before the body arrives
+    std::string_view head = Post.substr(0, Post.size() - 11);
+    EXPECT_TRUE(receiver.append(head.data(), head.size()));
+    EXPECT_EQ(receiver.error(), 413);
+
+    HttpRequest other;
+    RequestReceiver chunked(other, policy);
+    std::string_view request = "POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n6\r\nabcdef\r\n6\r\nghijkl\r\n";
+    EXPECT_TRUE(chunked.append(request.data(), request.size()));
+    EXPECT_EQ(chunked.error(), 413);
+}
+
+// CL.TE and TE.CL, each side of a proxy would frame the body its own way
+TEST(RequestFraming, ContentLengthWithTransferEncoding) {
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 6\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\nG"), 400);
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n"
+        "1\r\nG\r\n0\r\n\r\n"), 400);
+}
+
+TEST(RequestFraming, ChunkedNotLast) {
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked, gzip\r\n\r\n"), 400);
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: identity\r\n\r\n"), 400);
+}
+
+TEST(RequestFraming, UnsupportedCoding) {
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: gzip, chunked\r\n\r\n0\r\n\r\n"), 501);
+}
+
+TEST(RequestFraming, RepeatedFraming) {
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 1\r\n"
+        "Content-Length: 1\r\n\r\nG"), 400);
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "0\r\n\r\n"), 400);
+}
+
+TEST(FieldName, Token) {
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\nX-A_b.c~1: y\r\n\r\n"),
+        0);
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\nX:\r\n\r\n"), 0);
+}
+
+TEST(FieldName, Whitespace) {
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Content-Length : 5\r\n\r\nhello"), 400);
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding\t: chunked\r\n\r\n0\r\n\r\n"), 400);
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\n X: y\r\n\r\n"), 400);
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\nX: y\r\n"
+        "\tz\r\n\r\n"), 400);
+}
+
+TEST(FieldName, NotToken) {
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\n: y\r\n\r\n"), 400);
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\nX(1): y\r\n\r\n"),
+        400);
+    EXPECT_EQ(receive_("GET / HTTP/1.1\r\nHost: a\r\nX\"y: z\r\n\r\n"),
+        400);
+}
+
+TEST(Trailers, Dropped) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string_view request = "POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n1\r\nx\r\n0\r\n"
+        "X-Checksum: 1\r\nUser-Agent: b\r\n\r\n";
+    EXPECT_TRUE(receiver.append(request.data(), request.size()));
+    EXPECT_FALSE(receiver.bad());
+    EXPECT_EQ(message.header_count, 0u);
+    EXPECT_TRUE(message.header(HeaderUserAgent).empty());
+}
+
+TEST(Trailers, HeadFields) {
+    const char* fields[] = {
+        "Host: b", "Content-Length: 1", "Transfer-Encoding: chunked",
+        "Range: bytes=0-", "If-None-Match: *", "Cookie: a=b",
+        "Connection: close"
+    };
+    for (const char* field : fields) {
+        EXPECT_EQ(receive_(std::string("POST / HTTP/1.1\r\nHost: a\r\n"
+            "Transfer-Encoding: chunked\r\n\r\n0\r\n") + field
+            + "\r\n\r\n"), 400) << field;
+    }
+    EXPECT_EQ(receive_("POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n0\r\nX : y\r\n\r\n"), 400);
+}
+
+TEST(Trailers, SplitAndPipelined) {
+    BodyPolicy policy;
+    HttpRequest message;
+    RequestReceiver receiver(message, policy);
+    std::string_view request = "POST / HTTP/1.1\r\nHost: a\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n"
+        "X-A: 1\r\n\r\nGET /next HTTP/1.1\r\nHost: a\r\n\r\n";
+    size_t i = 0;
+    while (i < request.size() && !receiver.append(&request[i], 1)) ++i;
+    ASSERT_TRUE(receiver.done());
+    EXPECT_FALSE(receiver.bad());
+    EXPECT_EQ(body_(message), "abc");
+    for (++i; i < request.size(); ++i) receiver.append(&request[i], 1);
+    ASSERT_TRUE(receiver.next());
+    EXPECT_EQ(message.path, "/next");
+}
+
+} // namespace webstab
@@ -0,0 +1,106 @@
+// File:     test/ResponseWriterTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// response heads serialised into a fixed buffer, and the dates in them
+
+// C
+#include <cstdint>
+
+// C++
+#include <string>
+#include <string_view>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "http/HttpDate.h"
+#include "http/ResponseWriter.h"
+
+namespace webstab {
+
+TEST(ResponseWriter, Head) {
+    char buf[256];
+    ResponseWriter writer(buf, sizeof(buf));
+    writer.status(404);
+    writer.header("Content-Type", "text/html");
+    writer.header("Content-Length", size_t(0));
+    writer.header("X-Max", SIZE_MAX);
+    size_t length = writer.finish();
+    EXPECT_EQ(std::string_view(writer.data(), length),
+        "HTTP/1.1 404 Not Found\r\nContent-Type: text/html\r\n"
+        "Content-Length: 0\r\nX-Max: " + std::to_string(SIZE_MAX)
+        + "\r\n\r\n");
+}
+
+TEST(ResponseWriter, Date) {
+    char buf[64];
+    ResponseWriter writer(buf, sizeof(buf));
+    writer.date();
+    std::string line(writer.data(), writer.finish());
+    // 'Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n\r\n'
+    ASSERT_EQ(line.size(), 39u) << line;
+    EXPECT_EQ(line.compare(0, 6, "Date: "), 0) << line;
+    EXPECT_EQ(line.compare(31, 8, " GMT\r\n\r\n"), 0) << line;
+}
+
+TEST(ResponseWriter, Overflow) {
+    char buf[32];
+    ResponseWriter writer(buf, sizeof(buf));
+    writer.status(200);
+    writer.header("Server", "WebStable");
+    EXPECT_EQ(writer.finish(), 0u);
+    // a head that fills the buffer exactly is kept
+    ResponseWriter exact(buf, 19);
+    exact.status(200);
+    EXPECT_EQ(exact.finish(), 19u);
+}
+
+TEST(ResponseWriter, Reasons) {
+    EXPECT_EQ(status_reason(200), "OK");
+    EXPECT_EQ(status_reason(416), "Range Not Satisfiable");
+    EXPECT_EQ(status_reason(431), "Request Header Fields Too Large");
+    // unknown codes are answered as 500
+    EXPECT_EQ(status_reason(299), "Internal Server Error");
+}
+
+TEST(HttpDate, Format) {
+    char date[HttpDateLength + 1];
+    format_http_date(784111777, date);
+    EXPECT_STREQ(date, "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+TEST(HttpDate, Parse) {
+    EXPECT_EQ(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777);
+    EXPECT_EQ(parse_http_date("Thu, 01 Jan 1970 00:00:00 GMT"), 0);
+    // the obsolete formats and anything else are not dates
+    EXPECT_EQ(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT"), -1);
+    EXPECT_EQ(parse_http_date("Sun Nov  6 08:49:37 1994"), -1);
+    EXPECT_EQ(parse_http_date("Sun, 06 Nov 1994 08:49:37 UTC"), -1);
+    EXPECT_EQ(parse_http_date(""), -1);
+}
+
+} // namespace webstab
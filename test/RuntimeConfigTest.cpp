@@ -0,0 +1,188 @@
+// File:     test/RuntimeConfigTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// a configuration file compiled into the values of the request path
+
+// C
+#include <cstdio>
+#include <cstdlib>
+
+// C++
+#include <string>
+
+// Linux
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// WebStable
+#include "app/RuntimeConfig.h"
+
+namespace webstab {
+
+namespace {
+
+// writes 'text' to a temporary file, returns its path
+std::string write_(const std::string& text) {
+    char path[] = "/tmp/webstable-config-XXXXXX";
+    int fd = ::mkstemp(path);
+    EXPECT_NE(fd, -1);
+    FILE* file = ::fdopen(fd, "w");
+    std::fwrite(text.data(), 1, text.size(), file);
+    std::fclose(file);
+    return path;
+}
+
+// the configuration of 'text', read from a temporary file
+Config read_(const std::string& text) {
+    std::string path = write_(text);
+    Config config = Config::load(path);
+    ::unlink(path.c_str());
+    return config;
+}
+
+// the exit status a file of 'text' is refused with, 0 when it is read
+int refused_(const std::string& text) {
+    std::string path = write_(text);
+    int code = 0;
+    try {
+        Config::load(path);
+    } catch (const ConfigError& e) {
+        code = e.code();
+    }
+    ::unlink(path.c_str());
+    return code;
+}
+
+} // anonymous namespace
+
+TEST(MimeTable, Lookup) {
+    std::string text = "[static]\nroot = /tmp\n[types]\n"
+        "html htm = text/html\npng = image/png\n";
+    for (int i = 0; i < 100; ++i)
+        text += "x" + std::to_string(i) + " = type/" + std::to_string(i)
+            + '\n';
+    RuntimeConfig config(read_(text));
+    EXPECT_EQ(config.type("html").type, "text/html");
+    EXPECT_EQ(config.type("htm").type, "text/html");
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(config.type("x" + std::to_string(i)).type,
+            "type/" + std::to_string(i));
+    }
+    // 'gzip_types' marks the compressible ones
+    EXPECT_TRUE(config.type("html").compressible);
+    EXPECT_FALSE(config.type("png").compressible);
+}
+
+TEST(MimeTable, Default) {
+    RuntimeConfig config(read_("[server]\ndefault_type = text/plain\n"
+        "[static]\nroot = /tmp\n[types]\nhtml = text/html\n"));
+    EXPECT_EQ(config.type("").type, "text/plain");
+    EXPECT_EQ(config.type("HTML").type, "text/plain");
+    EXPECT_EQ(config.type("x").type, "text/plain");
+    EXPECT_TRUE(config.type("x").compressible);
+}
+
+TEST(RuntimeConfig, Values) {
+    RuntimeConfig config(read_("[server]\nkeepalive = 5\n"
+        "max_body_size = 2m\nbody_buffer_size = 4k\ncache_size = 1g\n"
+        "server_name = Test\n[static]\nroot = /var/www//\n"));
+    EXPECT_EQ(config.server_name(), "Test");
+    EXPECT_EQ(config.keepalive_ms(), 5000);
+    EXPECT_EQ(config.body_policy().max_size, 2u << 20);
+    EXPECT_EQ(config.body_policy().buffer_size, 4096u);
+    EXPECT_EQ(config.cache_size(), 1u << 30);
+    ASSERT_EQ(config.mounts().size(), 1u);
+    EXPECT_EQ(config.mounts()[0].dir, "/var/www");
+}
+
+TEST(RuntimeConfig, Mounts) {
+    RuntimeConfig config(read_("[server]\nindex = index.html\n"
+        "gzip_level = 6\n[static]\nroot = /srv/www\n"
+        "/docs = /srv/docs; index = README.html; gzip_level = 0\n"
+        "/docs/api = /srv/api; cache_control = max-age=600\n"));
+    std::string_view rest;
+    const Mount* mount = config.route("/docs/a.html", rest);
+    ASSERT_NE(mount, nullptr);
+    EXPECT_EQ(mount->dir, "/srv/docs");
+    EXPECT_EQ(mount->index, "README.html");
+    EXPECT_EQ(mount->cache_policy.gzip_level, 0);
+    EXPECT_EQ(rest, "/a.html");
+    mount = config.route("/docs/api/v1", rest);
+    ASSERT_NE(mount, nullptr);
+    EXPECT_EQ(mount->cache_control, "max-age=600");
+    EXPECT_EQ(mount->index, "index.html");
+    EXPECT_EQ(mount->cache_policy.gzip_level, 6);
+    EXPECT_EQ(rest, "/v1");
+    mount = config.route("/docsx", rest);
+    ASSERT_NE(mount, nullptr);
+    EXPECT_EQ(mount->dir, "/srv/www");
+    EXPECT_EQ(rest, "/docsx");
+    EXPECT_THROW(RuntimeConfig other(read_("[static]\n"
+        "root = /srv/www; expires = 1\n")), ConfigError);
+}
+
+TEST(ConfigLoad, Accept) {
+    Config config = read_("[static]\nroot = /tmp\n");
+    EXPECT_EQ(config.backlog(), 511);
+    EXPECT_EQ(config.defer_accept(), 0);
+    EXPECT_EQ(config.fastopen(), 0);
+    Config other = read_("[server]\nbacklog = 4096\ndefer_accept = 5\n"
+        "fastopen = 256\n[static]\nroot = /tmp\n");
+    EXPECT_EQ(other.backlog(), 4096);
+    EXPECT_EQ(other.defer_accept(), 5);
+    EXPECT_EQ(other.fastopen(), 256);
+}
+
+TEST(ConfigLoad, Tcp) {
+    Config config = read_("[static]\nroot = /tmp\n");
+    EXPECT_TRUE(config.tcp_nodelay());
+    EXPECT_EQ(config.tcp_sndbuf(), 0u);
+    EXPECT_EQ(config.tcp_notsent_lowat(), 0u);
+    EXPECT_EQ(config.tcp_linger(), -1);
+    Config other = read_("[static]\nroot = /tmp\n[tcp]\nnodelay = off\n"
+        "sndbuf = 64k\nrcvbuf = 32k\nlinger = 0\n");
+    EXPECT_FALSE(other.tcp_nodelay());
+    EXPECT_EQ(other.tcp_sndbuf(), 65536u);
+    EXPECT_EQ(other.tcp_rcvbuf(), 32768u);
+    EXPECT_EQ(other.tcp_linger(), 0);
+    EXPECT_FALSE(config.same_tcp(other));
+    EXPECT_NE(refused_("[static]\nroot = /tmp\n[tcp]\ncork = on\n"), 0);
+}
+
+// a reload keeps the running configuration when the file is refused
+TEST(ConfigLoad, Refused) {
+    EXPECT_EQ(refused_("[static]\nroot = /tmp\n"), 0);
+    EXPECT_EQ(refused_("[static\nroot = /tmp\n"), 3);
+    EXPECT_EQ(refused_("[other]\n"), 4);
+    EXPECT_EQ(refused_("root = /tmp\n"), 5);
+    EXPECT_EQ(refused_("[static]\nroot /tmp\n"), 6);
+    EXPECT_EQ(refused_("[static]\n = /tmp\n"), 7);
+    EXPECT_EQ(refused_("[server]\nindex = a.html\n"), 1);
+}
+
+} // namespace webstab
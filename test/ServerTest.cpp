@@ -0,0 +1,277 @@
+// File:     test/ServerTest.cpp
+// Author:   AkashiNeko
+// Project:  WebStable
+// Github:   https://github.com/AkashiNeko/WebStable/
+
+/* Copyright (c) 2024 AkashiNeko
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// end-to-end cases that start the server binary on loopback
+
+// C
+#include <cstdio>
+#include <cstdlib>
+
+// C++
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Linux
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// googletest
+#include <gtest/gtest.h>
+
+// bench
+#include "BenchServer.h"
+
+#ifndef WEBSTABLE_BINARY
+#define WEBSTABLE_BINARY "webstable"
+#endif
+
+namespace webstab {
+
+namespace {
+
+// a document root with one page, removed with the fixture
+class ServerTest : public ::testing::TestWithParam<const char*> {
+protected:
+    std::string dir_;
+    int port_ = 0;
+    pid_t pid_ = -1;
+
+    void SetUp() override {
+        char dir_template[] = "/tmp/webstable-test-XXXXXX";
+        ASSERT_NE(::mkdtemp(dir_template), nullptr);
+        dir_ = dir_template;
+        ASSERT_TRUE(bench::write_file(dir_ + "/index.html", "hello\n"));
+    }
+
+    void TearDown() override {
+        if (pid_ != -1) bench::stop_server(pid_);
+        ::unlink((dir_ + "/index.html").c_str());
+        ::unlink((dir_ + "/large.bin").c_str());
+        ::unlink((dir_ + "/test.conf").c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    // starts the server with the poller of the case and 'server_keys'
+    // added to its [server] section
+    void start_(const std::string& server_keys) {
+        port_ = bench::free_port();
+        std::string conf = dir_ + "/test.conf";
+        std::string text = "[server]\nlisten = 127.0.0.1:"
+            + std::to_string(port_) + "\npoller = " + GetParam() + '\n'
+            + server_keys + "[static]\nroot = " + dir_ + '\n';
+        ASSERT_TRUE(bench::write_file(conf, text));
+        pid_ = bench::start_server(WEBSTABLE_BINARY, conf, port_);
+    }
+};
+
+// the status of the next answer on 'fd', 0 when none arrives
+int read_status_(int fd) {
+    std::string head;
+    char buffer[1024];
+    while (head.find("\r\n\r\n") == std::string::npos) {
+        pollfd pfd{ fd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 5000) != 1) return 0;
+        ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) return 0;
+        head.append(buffer, static_cast<size_t>(length));
+    }
+    if (head.compare(0, 9, "HTTP/1.1 ") != 0) return 0;
+    return std::atoi(head.c_str() + 9);
+}
+
+// sends a keep-alive GET on 'fd', returns the status of the answer or 0
+int get_(int fd, const char* path) {
+    std::string request = std::string("GET ") + path
+        + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL)
+            != static_cast<ssize_t>(request.size()))
+        return 0;
+    return read_status_(fd);
+}
+
+// true once the server closed 'fd', within 'timeout' milliseconds
+bool closed_by_server_(int fd, int timeout) {
+    char buffer[1024];
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::milliseconds(timeout);
+    while (std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{ fd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 100) == 1
+                && ::recv(fd, buffer, sizeof(buffer), 0) <= 0)
+            return true;
+    }
+    return false;
+}
+
+// everything 'fd' receives until it stays quiet for 300 milliseconds
+std::string drain_(int fd) {
+    std::string received;
+    char buffer[4096];
+    pollfd pfd{ fd, POLLIN, 0 };
+    while (::poll(&pfd, 1, 300) == 1) {
+        ssize_t length = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) break;
+        received.append(buffer, static_cast<size_t>(length));
+    }
+    return received;
+}
+
+} // anonymous namespace
+
+// connections closed by the keep-alive timer leave the limit, round
+// after round, under every poller
+TEST_P(ServerTest, KeepAliveExpiryReleasesConnections) {
+    constexpr int Limit = 3;
+    start_("threads_num = 2\nkeepalive = 1\nmax_connections = "
+        + std::to_string(Limit) + '\n');
+    for (int round = 0; round < 4; ++round) {
+        int fds[Limit];
+        for (int i = 0; i < Limit; ++i) {
+            fds[i] = bench::connect_loopback(port_);
+            ASSERT_NE(fds[i], -1);
+            EXPECT_EQ(get_(fds[i], "/index.html"), 200)
+                << "round " << round << ", connection " << i;
+        }
+        for (int fd : fds) {
+            EXPECT_TRUE(closed_by_server_(fd, 5000));
+            ::close(fd);
+        }
+    }
+    EXPECT_TRUE(bench::server_alive(pid_));
+}
+
+// partial requests wait in the poller, the only worker still serves
+// the others at once
+TEST_P(ServerTest, PartialRequestsDoNotHoldWorkers) {
+    start_("threads_num = 1\nkeepalive = 5\n");
+    int slow[3];
+    for (int& fd : slow) {
+        fd = bench::connect_loopback(port_);
+        ASSERT_NE(fd, -1);
+        ASSERT_EQ(::send(fd, "GET / HTTP/1.1\r\nHo", 18, MSG_NOSIGNAL), 18);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int fd = bench::connect_loopback(port_);
+    ASSERT_NE(fd, -1);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(get_(fd, "/index.html"), 200);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+        std::chrono::milliseconds(500));
+    ::close(fd);
+
+    // the parked requests complete when the rest arrives
+    for (int fd : slow) {
+        ASSERT_EQ(::send(fd, "st: x\r\n\r\n", 9, MSG_NOSIGNAL), 9);
+        EXPECT_EQ(read_status_(fd), 200);
+        ::close(fd);
+    }
+}
+
+// a head that is still not complete after 'header_timeout' is answered
+// 408, however often bytes of it arrive
+TEST_P(ServerTest, HeadTimeout) {
+    start_("keepalive = 30\nheader_timeout = 1\n");
+    int fd = bench::connect_loopback(port_);
+    ASSERT_NE(fd, -1);
+    const char head[] = "GET /index.html HTTP/1.1\r\nX-Slow: ";
+    ASSERT_EQ(::send(fd, head, sizeof(head) - 1, MSG_NOSIGNAL),
+        static_cast<ssize_t>(sizeof(head) - 1));
+    std::string answer;
+    char buffer[1024];
+    for (int i = 0; i < 30 && answer.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ::send(fd, "a", 1, MSG_NOSIGNAL);
+        pollfd pfd{ fd, POLLIN, 0 };
+        ssize_t length;
+        if (::poll(&pfd, 1, 0) == 1
+                && (length = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            answer.assign(buffer, static_cast<size_t>(length));
+    }
+    EXPECT_EQ(answer.compare(0, 12, "HTTP/1.1 408"), 0) << answer;
+    ::close(fd);
+}
+
+// HEAD is answered with the head of the GET and no body, so the
+// pipelined GET behind it still lines up
+TEST_P(ServerTest, HeadHasNoBody) {
+    ASSERT_TRUE(bench::write_file(dir_ + "/large.bin",
+        std::string(1 << 20, 'x')));
+    start_("keepalive = 5\n");
+    int fd = bench::connect_loopback(port_);
+    ASSERT_NE(fd, -1);
+    std::string requests =
+        "HEAD /index.html HTTP/1.1\r\nHost: x\r\n\r\n"
+        "HEAD /large.bin HTTP/1.1\r\nHost: x\r\n\r\n"
+        "HEAD /large.bin HTTP/1.1\r\nHost: x\r\nRange: bytes=0-9\r\n\r\n"
+        "HEAD /missing HTTP/1.1\r\nHost: x\r\n\r\n"
+        "GET /index.html HTTP/1.1\r\nHost: x\r\n\r\n";
+    ASSERT_EQ(::send(fd, requests.data(), requests.size(), MSG_NOSIGNAL),
+        static_cast<ssize_t>(requests.size()));
+    std::string received = drain_(fd);
+    ::close(fd);
+
+    const char* statuses[] = { "200", "200", "200", "404", "200" };
+    const char* lengths[] = { "6", "1048576", "1048576", nullptr, "6" };
+    size_t pos = 0;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(received.compare(pos, 12,
+            std::string("HTTP/1.1 ") + statuses[i]), 0)
+            << "answer " << i << ": " << received.substr(pos);
+        size_t end = received.find("\r\n\r\n", pos);
+        ASSERT_NE(end, std::string::npos);
+        std::string head = received.substr(pos, end - pos);
+        if (lengths[i]) {
+            EXPECT_NE(head.find(std::string("Content-Length: ")
+                + lengths[i]), std::string::npos) << head;
+        }
+        pos = end + 4;
+    }
+    EXPECT_EQ(received.substr(pos), "hello\n");
+}
+
+// the metrics are served only to the addresses in 'status_allow', to
+// the others the path is an ordinary one
+TEST_P(ServerTest, StatusAllow) {
+    start_("status_path = /status\n");
+    int fd = bench::connect_loopback(port_);
+    ASSERT_NE(fd, -1);
+    EXPECT_EQ(get_(fd, "/status"), 200);
+    ::close(fd);
+    bench::stop_server(pid_);
+
+    start_("status_path = /status\nstatus_allow = 10.0.0.1\n");
+    fd = bench::connect_loopback(port_);
+    ASSERT_NE(fd, -1);
+    EXPECT_EQ(get_(fd, "/status"), 404);
+    ::close(fd);
+}
+
+INSTANTIATE_TEST_SUITE_P(Pollers, ServerTest,
+    ::testing::Values("select", "poll", "epoll"));
+
+} // namespace webstab